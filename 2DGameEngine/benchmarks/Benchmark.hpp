@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+/*
+ Helpers shared by the standalone benchmarks in this folder. The benchmarks are
+ not part of the game project, every .cpp here has its own main() and is built
+ on its own together with the engine sources it uses, e.g. with msvc:
+
+	cl /std:c++20 /O2 /EHsc /I..\libs PoolBenchmark.cpp ..\src\ECS\*.cpp ..\src\JobSystem\JobSystem.cpp ..\src\Logger\Logger.cpp
+
+ Build them in release, the numbers of a debug build say nothing
+*/
+
+// results are added here so the compiler can't drop the work that produced them
+inline volatile std::uint64_t benchmarkSink = 0;
+
+template <typename T>
+void KeepResult(T value) {
+	benchmarkSink = benchmarkSink + static_cast<std::uint64_t>(value);
+}
+
+class Stopwatch {
+public:
+	Stopwatch() : start(std::chrono::steady_clock::now()) {}
+
+	double GetMilliseconds() const {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point start;
+};
+
+/*
+ Run func several times and keep the fastest run, the one least disturbed by the
+ rest of the machine. func does its own setup and returns the milliseconds it measured
+*/
+template <typename TFunc>
+double BestOf(int runs, TFunc func) {
+	double best = std::numeric_limits<double>::max();
+	for (int run = 0; run < runs; run++) {
+		best = std::min(best, func());
+	}
+	return best;
+}
@@ -0,0 +1,139 @@
+#include "Benchmark.hpp"
+#include "../src/Physics/Integration.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/*
+ IntegrationBenchmark
+ Checks that the SSE2 and AVX2 integration kernels give the same results as the
+ scalar one, then times all three over 1M moving bodies. The check runs every
+ kernel on the same bodies over ranges whose begin and end don't line up with the
+ vector width, so the unaligned loads and the scalar tail are covered, and compares
+ positions, velocities and both change ticks, inside and outside the range.
+ Returns 1 if a kernel doesn't match
+*/
+
+// relative tolerance between kernels, they do the same float operations in the same order
+const float TOLERANCE = 1e-6f;
+
+struct Bodies {
+	std::vector<float> positionX, positionY, velocityX, velocityY, accelerationX, accelerationY, damping;
+	std::vector<std::uint32_t> transformTicks, rigidBodyTicks;
+
+	/*
+	 Random bodies with every case the kernels branch on: some stand still, some only
+	 coast, some accelerate and some are damped as well
+	*/
+	Bodies(int count, unsigned int seed) {
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+		std::uniform_int_distribution<int> kind(0, 3);
+		for (int i = 0; i < count; i++) {
+			const int bodyKind = kind(random);
+			positionX.push_back(value(random));
+			positionY.push_back(value(random));
+			velocityX.push_back(bodyKind == 0 ? 0.0f : value(random));
+			velocityY.push_back(bodyKind == 0 ? 0.0f : value(random));
+			accelerationX.push_back(bodyKind >= 2 ? value(random) : 0.0f);
+			accelerationY.push_back(bodyKind >= 2 ? value(random) : 0.0f);
+			damping.push_back(bodyKind == 3 ? std::fabs(value(random)) * 0.02f : 0.0f);
+			transformTicks.push_back(1);
+			rigidBodyTicks.push_back(1);
+		}
+	}
+
+	IntegrationArrays GetArrays() {
+		return {
+			positionX.data(), positionY.data(), velocityX.data(), velocityY.data(),
+			accelerationX.data(), accelerationY.data(), damping.data(),
+			transformTicks.data(), rigidBodyTicks.data()
+		};
+	}
+};
+
+bool NearlyEqual(float a, float b) {
+	return a == b || std::fabs(a - b) <= TOLERANCE * std::max(std::fabs(a), std::fabs(b));
+}
+
+// index of the first body that differs, -1 if all of them match
+int FindMismatch(const Bodies& expected, const Bodies& actual) {
+	for (int i = 0; i < static_cast<int>(expected.positionX.size()); i++) {
+		const bool matches =
+			NearlyEqual(expected.positionX[i], actual.positionX[i]) && NearlyEqual(expected.positionY[i], actual.positionY[i]) &&
+			NearlyEqual(expected.velocityX[i], actual.velocityX[i]) && NearlyEqual(expected.velocityY[i], actual.velocityY[i]) &&
+			expected.transformTicks[i] == actual.transformTicks[i] && expected.rigidBodyTicks[i] == actual.rigidBodyTicks[i];
+		if (!matches) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// run the kernel and the scalar kernel over [begin, end) for a few steps and compare the bodies
+bool CheckRange(Integration::Kernel kernel, int count, int begin, int end) {
+	Bodies expected(count, 42);
+	Bodies actual(count, 42);
+	const IntegrationArrays expectedArrays = expected.GetArrays();
+	const IntegrationArrays actualArrays = actual.GetArrays();
+	for (std::uint32_t tick = 2; tick < 6; tick++) {
+		Integration::Integrate(Integration::Kernel::Scalar, expectedArrays, begin, end, 1.0f / 60.0f, tick);
+		Integration::Integrate(kernel, actualArrays, begin, end, 1.0f / 60.0f, tick);
+	}
+
+	const int mismatch = FindMismatch(expected, actual);
+	if (mismatch != -1) {
+		std::printf("FAILED: %s differs from Scalar at body %d of range [%d, %d)\n", Integration::GetKernelName(kernel), mismatch, begin, end);
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	const int bodyCount = 1000000;
+	const Integration::Kernel kernels[] = { Integration::Kernel::Scalar, Integration::Kernel::SSE2, Integration::Kernel::AVX2 };
+
+	// ranges that start and end off the 4 and 8 wide vector steps, and ranges shorter than one step
+	const int ranges[][2] = {
+		{ 0, bodyCount }, { 1, bodyCount }, { 3, bodyCount - 1 }, { 5, bodyCount - 3 }, { 7, bodyCount - 7 },
+		{ 0, 3 }, { 1, 8 }, { 2, 9 }, { 13, 30 }, { 100, 100 }, { 999, 1006 }
+	};
+
+	bool passed = true;
+	for (Integration::Kernel kernel : { Integration::Kernel::SSE2, Integration::Kernel::AVX2 }) {
+		if (!Integration::IsSupported(kernel)) {
+			std::printf("%s isn't supported by this cpu, skipped\n", Integration::GetKernelName(kernel));
+			continue;
+		}
+		for (const auto& range : ranges) {
+			passed = CheckRange(kernel, bodyCount, range[0], range[1]) && passed;
+		}
+	}
+	std::printf("kernels %s the scalar results within a relative %g\n", passed ? "match" : "don't match", TOLERANCE);
+
+	std::printf("%-8s %12s %9s\n", "kernel", "ms", "speedup");
+	double scalarMilliseconds = 0.0;
+	for (Integration::Kernel kernel : kernels) {
+		if (!Integration::IsSupported(kernel)) {
+			continue;
+		}
+		Bodies bodies(bodyCount, 7);
+		const IntegrationArrays arrays = bodies.GetArrays();
+		std::uint32_t tick = 2;
+		const double milliseconds = BestOf(20, [&]() {
+			Stopwatch stopwatch;
+			Integration::Integrate(kernel, arrays, 0, bodyCount, 1.0f / 60.0f, tick++);
+			return stopwatch.GetMilliseconds();
+		});
+		KeepResult(bodies.positionX[bodyCount - 1]);
+
+		if (kernel == Integration::Kernel::Scalar) {
+			scalarMilliseconds = milliseconds;
+		}
+		std::printf("%-8s %12.3f %8.2fx\n", Integration::GetKernelName(kernel), milliseconds, scalarMilliseconds / milliseconds);
+	}
+	return passed ? 0 : 1;
+}
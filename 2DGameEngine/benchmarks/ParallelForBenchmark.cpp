@@ -0,0 +1,89 @@
+#include "Benchmark.hpp"
+#include "../src/JobSystem/JobSystem.hpp"
+#include "../src/Physics/Integration.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+/*
+ ParallelForBenchmark
+ Runs the same loops through JobSystem::ParallelFor() with 1, 2, 4, 8 and 16
+ threads, the calling thread counts as one of them. The integration loop is the
+ one MovementSystem runs and mostly waits on memory, the rotation loop does the
+ trigonometry TransformSystem does per node and is bound by the cores. Thread
+ counts above the number of cores are still run, they show what oversubscription costs
+*/
+
+struct Bodies {
+	std::vector<float> positionX, positionY, velocityX, velocityY, accelerationX, accelerationY, damping;
+	std::vector<std::uint32_t> transformTicks, rigidBodyTicks;
+
+	Bodies(int count) :
+		positionX(count, 0.0f), positionY(count, 0.0f), velocityX(count, 10.0f), velocityY(count, 5.0f),
+		accelerationX(count, 0.0f), accelerationY(count, -9.8f), damping(count, 0.1f),
+		transformTicks(count, 0), rigidBodyTicks(count, 0) {}
+
+	IntegrationArrays GetArrays() {
+		return {
+			positionX.data(), positionY.data(), velocityX.data(), velocityY.data(),
+			accelerationX.data(), accelerationY.data(), damping.data(),
+			transformTicks.data(), rigidBodyTicks.data()
+		};
+	}
+};
+
+int main() {
+	const int bodyCount = 1000000;
+	const int nodeCount = 1000000;
+	const int runs = 10;
+
+	Bodies bodies(bodyCount);
+	const IntegrationArrays arrays = bodies.GetArrays();
+	std::vector<float> rotations(nodeCount);
+	for (int i = 0; i < nodeCount; i++) {
+		rotations[i] = static_cast<float>(i % 360);
+	}
+	std::vector<float> axes(nodeCount * 2);
+
+	std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+	std::printf("%-8s %16s %9s %16s %9s\n", "threads", "integrate ms", "speedup", "rotate ms", "speedup");
+
+	double integrateBase = 0.0;
+	double rotateBase = 0.0;
+	for (int threadCount : { 1, 2, 4, 8, 16 }) {
+		JobSystem jobSystem(threadCount - 1);
+		std::uint32_t tick = 1;
+
+		const double integrate = BestOf(runs, [&]() {
+			Stopwatch stopwatch;
+			jobSystem.ParallelFor(bodyCount, [&arrays, tick](int begin, int end) {
+				Integration::Integrate(arrays, begin, end, 1.0f / 60.0f, tick);
+			});
+			tick++;
+			return stopwatch.GetMilliseconds();
+		});
+
+		const double rotate = BestOf(runs, [&]() {
+			Stopwatch stopwatch;
+			jobSystem.ParallelFor(nodeCount, [&rotations, &axes](int begin, int end) {
+				for (int i = begin; i < end; i++) {
+					const float radians = rotations[i] * 0.0174532925f;
+					axes[i * 2] = std::cos(radians);
+					axes[i * 2 + 1] = std::sin(radians);
+				}
+			});
+			return stopwatch.GetMilliseconds();
+		});
+		KeepResult(axes[nodeCount - 1] * 1000.0f);
+
+		if (threadCount == 1) {
+			integrateBase = integrate;
+			rotateBase = rotate;
+		}
+		std::printf("%-8d %16.3f %8.2fx %16.3f %8.2fx\n", threadCount, integrate, integrateBase / integrate, rotate, rotateBase / rotate);
+	}
+	KeepResult(bodies.positionX[bodyCount - 1]);
+	return 0;
+}
@@ -0,0 +1,162 @@
+#include "Benchmark.hpp"
+#include "../src/ECS/ECS.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+/*
+ PoolBenchmark
+ Compares the sparse set Pool<T> with the pool it replaced, which mapped entity ids
+ to packed indices through two unordered_maps. Both pools add, look up and remove
+ the same entity ids at 10k, 100k and 1M entities
+*/
+
+struct BenchmarkComponent {
+	glm::vec2 position;
+	glm::vec2 velocity;
+
+	BenchmarkComponent(glm::vec2 position = glm::vec2(0, 0), glm::vec2 velocity = glm::vec2(0, 0)) : position(position), velocity(velocity) {}
+};
+
+// the pool before the sparse set, kept as it was apart from the name
+template <typename T>
+class HashMapPool {
+public:
+	HashMapPool(int capacity = 100) {
+		size = 0;
+		data.resize(capacity);
+	}
+
+	void Set(int entityId, T object) {
+		if (entityIdToIndex.find(entityId) != entityIdToIndex.end()) {
+			// if element already exists, replace the object
+			int index = entityIdToIndex[entityId];
+			data[index] = object;
+		}
+		else {
+			// add new object, track entity id and vector index
+			int index = size;
+			entityIdToIndex.emplace(entityId, index);
+			indexToEntityId.emplace(index, entityId);
+			if (index >= data.capacity()) {
+				// resize if data is not big enough
+				data.resize(size * 2);
+			}
+			data[index] = object;
+			size++;
+		}
+	}
+
+	void Remove(int entityId) {
+		// copy last element to the deleted position to keep the array packed
+		int indexOfRemoved = entityIdToIndex[entityId];
+		int indexOfLast = size - 1;
+		data[indexOfRemoved] = data[indexOfLast];
+
+		// update the index-entity maps to point to correct elements
+		int entityIdOfLastElement = indexToEntityId[indexOfLast];
+		entityIdToIndex[entityIdOfLastElement] = indexOfRemoved;
+		indexToEntityId[indexOfRemoved] = entityIdOfLastElement;
+
+		entityIdToIndex.erase(entityId);
+		indexToEntityId.erase(indexOfLast);
+
+		size--;
+	}
+
+	T& Get(int entityId) {
+		int index = entityIdToIndex[entityId];
+		return static_cast<T&>(data[index]);
+	}
+
+private:
+	std::vector<T> data;
+	int size;
+	std::unordered_map<int, int> entityIdToIndex;
+	std::unordered_map<int, int> indexToEntityId;
+};
+
+struct PoolTimings {
+	double set = 0.0;
+	double getInOrder = 0.0;
+	double getShuffled = 0.0;
+	double remove = 0.0;
+};
+
+/*
+ Time every operation on a fresh pool per run. Lookups go over the ids in the order
+ they were added, like a system walking its entities, and in random order, like
+ the entities of collision events. Half of the entities are removed in random order
+*/
+template <typename TPool>
+PoolTimings MeasurePool(const std::vector<int>& entityIds, const std::vector<int>& shuffledIds, int runs) {
+	PoolTimings timings;
+	timings.set = BestOf(runs, [&]() {
+		TPool pool;
+		Stopwatch stopwatch;
+		for (int entityId : entityIds) {
+			pool.Set(entityId, BenchmarkComponent(glm::vec2(entityId, 0), glm::vec2(1, 1)));
+		}
+		return stopwatch.GetMilliseconds();
+	});
+
+	TPool pool;
+	for (int entityId : entityIds) {
+		pool.Set(entityId, BenchmarkComponent(glm::vec2(entityId, 0), glm::vec2(1, 1)));
+	}
+	auto measureGets = [&](const std::vector<int>& ids) {
+		return BestOf(runs, [&]() {
+			Stopwatch stopwatch;
+			float sum = 0.0f;
+			for (int entityId : ids) {
+				BenchmarkComponent& component = pool.Get(entityId);
+				component.position += component.velocity;
+				sum += component.position.y;
+			}
+			KeepResult(sum);
+			return stopwatch.GetMilliseconds();
+		});
+	};
+	timings.getInOrder = measureGets(entityIds);
+	timings.getShuffled = measureGets(shuffledIds);
+
+	const std::vector<int> removedIds(shuffledIds.begin(), shuffledIds.begin() + shuffledIds.size() / 2);
+	timings.remove = BestOf(runs, [&]() {
+		TPool pool;
+		for (int entityId : entityIds) {
+			pool.Set(entityId, BenchmarkComponent());
+		}
+		Stopwatch stopwatch;
+		for (int entityId : removedIds) {
+			pool.Remove(entityId);
+		}
+		return stopwatch.GetMilliseconds();
+	});
+	return timings;
+}
+
+int main() {
+	const int runs = 5;
+	std::mt19937 random(1234);
+
+	std::printf("%-10s %-10s %12s %12s %12s %12s\n", "entities", "pool", "set ms", "get ms", "shuffled ms", "remove ms");
+	for (int entityCount : { 10000, 100000, 1000000 }) {
+		std::vector<int> entityIds(entityCount);
+		std::iota(entityIds.begin(), entityIds.end(), 0);
+		std::vector<int> shuffledIds = entityIds;
+		std::shuffle(shuffledIds.begin(), shuffledIds.end(), random);
+
+		const PoolTimings hashMap = MeasurePool<HashMapPool<BenchmarkComponent>>(entityIds, shuffledIds, runs);
+		const PoolTimings sparseSet = MeasurePool<Pool<BenchmarkComponent>>(entityIds, shuffledIds, runs);
+
+		std::printf("%-10d %-10s %12.3f %12.3f %12.3f %12.3f\n", entityCount, "hash map", hashMap.set, hashMap.getInOrder, hashMap.getShuffled, hashMap.remove);
+		std::printf("%-10d %-10s %12.3f %12.3f %12.3f %12.3f\n", entityCount, "sparse set", sparseSet.set, sparseSet.getInOrder, sparseSet.getShuffled, sparseSet.remove);
+		std::printf("%-10d %-10s %11.1fx %11.1fx %11.1fx %11.1fx\n", entityCount, "speedup",
+			hashMap.set / sparseSet.set, hashMap.getInOrder / sparseSet.getInOrder, hashMap.getShuffled / sparseSet.getShuffled, hashMap.remove / sparseSet.remove);
+	}
+	return 0;
+}
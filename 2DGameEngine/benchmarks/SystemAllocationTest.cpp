@@ -0,0 +1,151 @@
+#include "Benchmark.hpp"
+#include "../src/ECS/ECS.hpp"
+#include "../src/ECS/SystemScheduler.hpp"
+#include "../src/JobSystem/JobSystem.hpp"
+#include "../src/EventBus/EventBus.hpp"
+#include "../src/Components/TransformComponent.hpp"
+#include "../src/Components/RigidBodyComponent.hpp"
+#include "../src/Components/BoxColliderComponent.hpp"
+#include "../src/Components/ParentComponent.hpp"
+#include "../src/Systems/MovementSystem.hpp"
+#include "../src/Systems/TransformSystem.hpp"
+#include "../src/Systems/CollisionSystem.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+/*
+ SystemAllocationTest
+ Checks that a system tick doesn't touch the heap once the world stops changing.
+ Every operator new of the process is counted, the registry and the systems run
+ through the scheduler like in Game::Update() for a few frames so buffers reach
+ their size, then the frames after that must not allocate at all.
+ Returns 1 and prints the number of allocations if they do
+*/
+
+static std::atomic<long long> allocationCount{ 0 };
+
+static void* Allocate(std::size_t size, std::size_t alignment) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	size = size == 0 ? 1 : size;
+#if defined(_MSC_VER)
+	void* memory = _aligned_malloc(size, alignment);
+#else
+	// aligned_alloc wants a size that is a multiple of the alignment
+	void* memory = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+static void Free(void* memory) {
+#if defined(_MSC_VER)
+	_aligned_free(memory);
+#else
+	std::free(memory);
+#endif
+}
+
+void* operator new(std::size_t size) { return Allocate(size, alignof(std::max_align_t)); }
+void* operator new[](std::size_t size) { return Allocate(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return Allocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return Allocate(size, static_cast<std::size_t>(alignment)); }
+void operator delete(void* memory) noexcept { Free(memory); }
+void operator delete[](void* memory) noexcept { Free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { Free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { Free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { Free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { Free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { Free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { Free(memory); }
+
+// walks its entities the way the systems without a view or a kernel do
+class LifetimeSystem : public System {
+public:
+	LifetimeSystem() {
+		RequireComponent<RigidBodyComponent>(ComponentAccess::Read);
+	}
+
+	void Update() {
+		float speed = 0.0f;
+		for (Entity entity : GetSystemEntities()) {
+			const RigidBodyComponent rigidBody = GetComponent<RigidBodyComponent>(entity);
+			speed += rigidBody.velocity.x;
+		}
+		KeepResult(speed);
+	}
+};
+
+int main() {
+	const int entityCount = 2000;
+	const int warmUpFrames = 10;
+	const int measuredFrames = 100;
+	const double deltaTime = 1.0 / 60.0;
+
+	JobSystem jobSystem;
+	std::unique_ptr<EventBus> eventBus = std::make_unique<EventBus>();
+	std::unique_ptr<Registry> registry = std::make_unique<Registry>();
+	registry->AddSystem<MovementSystem>();
+	registry->AddSystem<TransformSystem>();
+	registry->AddSystem<CollisionSystem>();
+	registry->AddSystem<LifetimeSystem>();
+
+	// every body moves the same way, 100 pixels apart, so nothing collides and nothing is logged
+	std::vector<Entity> entities = registry->CreateEntities(entityCount);
+	std::vector<TransformComponent> transforms;
+	std::vector<RigidBodyComponent> rigidBodies;
+	std::vector<BoxColliderComponent> colliders;
+	for (int i = 0; i < entityCount; i++) {
+		transforms.push_back(TransformComponent(glm::vec2(i * 100.0f, 0.0f)));
+		rigidBodies.push_back(RigidBodyComponent(glm::vec2(10.0f, 5.0f)));
+		colliders.push_back(BoxColliderComponent(32, 32));
+	}
+	registry->AddComponents<TransformComponent>(entities, transforms);
+	registry->AddComponents<RigidBodyComponent>(entities, rigidBodies);
+	registry->AddComponents<BoxColliderComponent>(entities, colliders);
+
+	// a turret on every tenth body
+	std::vector<Entity> turrets = registry->CreateEntities(entityCount / 10);
+	std::vector<ParentComponent> parents;
+	for (int i = 0; i < static_cast<int>(turrets.size()); i++) {
+		parents.push_back(ParentComponent(entities[i * 10], glm::vec2(8.0f, 0.0f)));
+	}
+	registry->AddComponents<TransformComponent>(turrets, std::vector<TransformComponent>(turrets.size()));
+	registry->AddComponents<ParentComponent>(turrets, parents);
+
+	SystemScheduler scheduler(jobSystem);
+	scheduler.AddTask(registry->GetSystem<MovementSystem>(), [&jobSystem](MovementSystem& system, double elapsed) { system.Update(elapsed, jobSystem); });
+	scheduler.AddTask(registry->GetSystem<TransformSystem>(), [&jobSystem](TransformSystem& system) { system.Update(jobSystem); });
+	scheduler.AddTask(registry->GetSystem<CollisionSystem>(), [&eventBus](CollisionSystem& system) { system.Update(eventBus); });
+	scheduler.AddTask(registry->GetSystem<LifetimeSystem>(), [](LifetimeSystem& system) { system.Update(); }, SystemStage::PostUpdate);
+
+	auto runFrame = [&]() {
+		registry->Update();
+		scheduler.BeginFrame(deltaTime);
+		scheduler.Run(SystemStage::PreUpdate);
+		scheduler.Run(SystemStage::Update);
+		scheduler.Run(SystemStage::PostUpdate);
+	};
+
+	for (int frame = 0; frame < warmUpFrames; frame++) {
+		runFrame();
+	}
+
+	allocationCount.store(0);
+	for (int frame = 0; frame < measuredFrames; frame++) {
+		runFrame();
+	}
+	const long long allocations = allocationCount.load();
+
+	if (allocations != 0) {
+		std::printf("FAILED: %lld heap allocations in %d steady state frames\n", allocations, measuredFrames);
+		return 1;
+	}
+	std::printf("passed: no heap allocations in %d steady state frames of %d entities\n", measuredFrames, entityCount);
+	return 0;
+}
@@ -0,0 +1,289 @@
+#include "Benchmark.hpp"
+#include "../src/ECS/ECS.hpp"
+#include "../src/ECS/View.hpp"
+#include "../src/JobSystem/JobSystem.hpp"
+#include "../src/EventBus/EventBus.hpp"
+#include "../src/Components/TransformComponent.hpp"
+#include "../src/Components/RigidBodyComponent.hpp"
+#include "../src/Components/SpriteComponent.hpp"
+#include "../src/Components/HealthComponent.hpp"
+#include "../src/Components/BoxColliderComponent.hpp"
+#include "../src/Systems/MovementSystem.hpp"
+#include "../src/Systems/CollisionSystem.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+/*
+ ViewBenchmark
+ Times MovementSystem, RenderSystem, CollisionSystem and RenderHealthBarSystem
+ against the loops they had before they were ported to views, which fetched every
+ component of every entity through Entity::GetComponent(). Both run on the same
+ registry, in pool and in archetype storage. MovementSystem and CollisionSystem
+ are the game's systems. The render systems can't run without a renderer, so their
+ loops are copied here with the SDL calls left out. SpriteComponent includes
+ SDL.h, so this one also needs the SDL include path
+*/
+
+class GetComponentMovementSystem : public System {
+public:
+	GetComponentMovementSystem() {
+		RequireComponent<TransformComponent>();
+		RequireComponent<RigidBodyComponent>();
+	}
+
+	void Update(double deltaTime) {
+		for (Entity entity : GetSystemEntities()) {
+			auto transform = entity.GetMutableComponent<TransformComponent>();
+			const RigidBodyComponent rigidbody = entity.GetComponent<RigidBodyComponent>();
+
+			transform.position.x += rigidbody.velocity.x * deltaTime;
+			transform.position.y += rigidbody.velocity.y * deltaTime;
+		}
+	}
+};
+
+// what RenderSystem::Update() does before SDL_RenderCopyEx(), the destination rectangles are summed instead
+struct RenderResult {
+	std::int64_t sum = 0;
+
+	void Add(const TransformComponent& transform, const SpriteComponent& sprite, const SDL_Rect& camera) {
+		sum += static_cast<int>(transform.position.x - (sprite.isFixed ? 0 : camera.x));
+		sum += static_cast<int>(transform.position.y - (sprite.isFixed ? 0 : camera.y));
+		sum += static_cast<int>(sprite.width * transform.scale.x);
+		sum += static_cast<int>(sprite.height * transform.scale.y);
+	}
+};
+
+class GetComponentRenderSystem : public System {
+public:
+	GetComponentRenderSystem() {
+		RequireComponent<TransformComponent>(ComponentAccess::Read);
+		RequireComponent<SpriteComponent>(ComponentAccess::Read);
+	}
+
+	void Update(SDL_Rect camera) {
+		struct RenderableEntity {
+			TransformComponent transformComponent;
+			SpriteComponent spriteComponent;
+		};
+
+		std::vector<RenderableEntity> renderableEntities;
+
+		for (Entity entity : GetSystemEntities()) {
+			RenderableEntity renderableEntity;
+			renderableEntity.spriteComponent = entity.GetComponent<SpriteComponent>();
+			renderableEntity.transformComponent = entity.GetComponent<TransformComponent>();
+			renderableEntities.emplace_back(renderableEntity);
+		}
+
+		std::sort(renderableEntities.begin(), renderableEntities.end(), [](const RenderableEntity& a, const RenderableEntity& b) {
+			return a.spriteComponent.zIndex < b.spriteComponent.zIndex;
+		});
+
+		RenderResult result;
+		for (const RenderableEntity& entity : renderableEntities) {
+			result.Add(entity.transformComponent, entity.spriteComponent, camera);
+		}
+		KeepResult(result.sum);
+	}
+};
+
+class ViewRenderSystem : public System {
+public:
+	ViewRenderSystem() {
+		RequireComponent<TransformComponent>(ComponentAccess::Read);
+		RequireComponent<SpriteComponent>(ComponentAccess::Read);
+	}
+
+	void Update(SDL_Rect camera) {
+		renderableEntities.clear();
+
+		registry->View<const TransformComponent, const SpriteComponent>().Each([this](Entity, const TransformComponent& transform, const SpriteComponent& sprite) {
+			renderableEntities.push_back({ transform, &sprite });
+		});
+
+		std::sort(renderableEntities.begin(), renderableEntities.end(), [](const RenderableEntity& a, const RenderableEntity& b) {
+			return a.spriteComponent->zIndex < b.spriteComponent->zIndex;
+		});
+
+		RenderResult result;
+		for (const RenderableEntity& entity : renderableEntities) {
+			result.Add(entity.transformComponent, *entity.spriteComponent, camera);
+		}
+		KeepResult(result.sum);
+	}
+
+private:
+	struct RenderableEntity {
+		TransformComponent transformComponent;
+		const SpriteComponent* spriteComponent;
+	};
+
+	std::vector<RenderableEntity> renderableEntities;
+};
+
+class GetComponentCollisionSystem : public System {
+public:
+	GetComponentCollisionSystem() {
+		RequireComponent<TransformComponent>(ComponentAccess::Read);
+		RequireComponent<BoxColliderComponent>(ComponentAccess::Read);
+	}
+
+	void Update(std::unique_ptr<EventBus>& eventBus) {
+		std::vector<Entity> entities(GetSystemEntities().begin(), GetSystemEntities().end());
+
+		for (auto i = entities.begin(); i != entities.end(); i++) {
+			Entity a = *i;
+
+			TransformComponent aTransform = a.GetComponent<TransformComponent>();
+			BoxColliderComponent aCollider = a.GetComponent<BoxColliderComponent>();
+
+			for (auto j = i + 1; j != entities.end(); j++) {
+				Entity b = *j;
+
+				TransformComponent bTransform = b.GetComponent<TransformComponent>();
+				BoxColliderComponent bCollider = b.GetComponent<BoxColliderComponent>();
+
+				const bool collided =
+					aTransform.position.x + aCollider.offset.x < bTransform.position.x + bCollider.offset.x + bCollider.width &&
+					aTransform.position.x + aCollider.offset.x + aCollider.width > bTransform.position.x + bCollider.offset.x &&
+					aTransform.position.y + aCollider.offset.y < bTransform.position.y + bCollider.offset.y + bCollider.height &&
+					aTransform.position.y + aCollider.offset.y + aCollider.height > bTransform.position.y + bCollider.offset.y;
+
+				if (collided) {
+					eventBus->EmitEvent<CollisionEvent>(a, b);
+				}
+			}
+		}
+	}
+};
+
+// what RenderHealthBarSystem::Update() works out before it draws, the rectangles are summed instead
+struct HealthBarResult {
+	std::int64_t sum = 0;
+
+	void Add(const TransformComponent& transform, const SpriteComponent& sprite, const HealthComponent& health, const SDL_Rect& camera) {
+		const double healthBarPosX = (transform.position.x + (sprite.width * transform.scale.x)) - camera.x;
+		const double healthBarPosY = (transform.position.y) - camera.y;
+		sum += static_cast<int>(healthBarPosX) + static_cast<int>(healthBarPosY) + static_cast<int>(15 * (health.healthPercentage / 100.0));
+		sum += health.healthPercentage < 40 ? 1 : (health.healthPercentage < 80 ? 2 : 3);
+	}
+};
+
+class GetComponentHealthBarSystem : public System {
+public:
+	GetComponentHealthBarSystem() {
+		RequireComponent<TransformComponent>(ComponentAccess::Read);
+		RequireComponent<SpriteComponent>(ComponentAccess::Read);
+		RequireComponent<HealthComponent>(ComponentAccess::Read);
+	}
+
+	void Update(const SDL_Rect& camera) {
+		HealthBarResult result;
+		for (auto entity : GetSystemEntities()) {
+			const auto transform = entity.GetComponent<TransformComponent>();
+			const auto sprite = entity.GetComponent<SpriteComponent>();
+			const auto health = entity.GetComponent<HealthComponent>();
+			result.Add(transform, sprite, health, camera);
+		}
+		KeepResult(result.sum);
+	}
+};
+
+class ViewHealthBarSystem : public System {
+public:
+	ViewHealthBarSystem() {
+		RequireComponent<TransformComponent>(ComponentAccess::Read);
+		RequireComponent<SpriteComponent>(ComponentAccess::Read);
+		RequireComponent<HealthComponent>(ComponentAccess::Read);
+	}
+
+	void Update(const SDL_Rect& camera) {
+		HealthBarResult result;
+		registry->View<const TransformComponent, const SpriteComponent, const HealthComponent>().Each([&](Entity, const TransformComponent& transform, const SpriteComponent& sprite, const HealthComponent& health) {
+			result.Add(transform, sprite, health, camera);
+		});
+		KeepResult(result.sum);
+	}
+};
+
+// milliseconds per call of update, the best of a few runs of several calls
+template <typename TFunc>
+double MeasureUpdate(TFunc update) {
+	const int callsPerRun = 10;
+	return BestOf(5, [&]() {
+		Stopwatch stopwatch;
+		for (int call = 0; call < callsPerRun; call++) {
+			update();
+		}
+		return stopwatch.GetMilliseconds() / callsPerRun;
+	});
+}
+
+void PrintRow(const char* system, double getComponent, double view) {
+	std::printf("  %-24s %14.3f %14.3f %9.1fx\n", system, getComponent, view, getComponent / view);
+}
+
+void RunBenchmark(StorageMode storageMode, int entityCount, int colliderCount) {
+	// the worker count is 0 so the systems run on this thread like the loops they are compared with
+	JobSystem jobSystem(0);
+	std::unique_ptr<EventBus> eventBus = std::make_unique<EventBus>();
+	Registry registry(storageMode);
+	registry.AddSystem<MovementSystem>();
+	registry.AddSystem<GetComponentMovementSystem>();
+	registry.AddSystem<ViewRenderSystem>();
+	registry.AddSystem<GetComponentRenderSystem>();
+	registry.AddSystem<CollisionSystem>();
+	registry.AddSystem<GetComponentCollisionSystem>();
+	registry.AddSystem<ViewHealthBarSystem>();
+	registry.AddSystem<GetComponentHealthBarSystem>();
+
+	std::vector<Entity> entities = registry.CreateEntities(entityCount);
+	std::vector<TransformComponent> transforms;
+	std::vector<RigidBodyComponent> rigidBodies;
+	std::vector<SpriteComponent> sprites;
+	std::vector<HealthComponent> healths;
+	for (int i = 0; i < entityCount; i++) {
+		// 100 pixels apart and moving the same way, so the colliders never touch
+		transforms.push_back(TransformComponent(glm::vec2(i * 100.0f, (i % 64) * 10.0f)));
+		rigidBodies.push_back(RigidBodyComponent(glm::vec2(10.0f, 5.0f)));
+		sprites.push_back(SpriteComponent("tank-image", 32, 32, i % 4));
+		healths.push_back(HealthComponent(i % 101));
+	}
+	registry.AddComponents<TransformComponent>(entities, transforms);
+	registry.AddComponents<RigidBodyComponent>(entities, rigidBodies);
+	registry.AddComponents<SpriteComponent>(entities, sprites);
+	registry.AddComponents<HealthComponent>(entities, healths);
+
+	const std::vector<Entity> colliding(entities.begin(), entities.begin() + colliderCount);
+	registry.AddComponents<BoxColliderComponent>(colliding, std::vector<BoxColliderComponent>(colliding.size(), BoxColliderComponent(32, 32)));
+	registry.Update();
+
+	const SDL_Rect camera = { 0, 0, 1000, 800 };
+	const double deltaTime = 1.0 / 60.0;
+
+	std::printf("%s storage, %d entities, %d colliders\n", storageMode == StorageMode::Pools ? "pool" : "archetype", entityCount, colliderCount);
+	std::printf("  %-24s %14s %14s %10s\n", "system", "GetComponent ms", "view ms", "speedup");
+	PrintRow("MovementSystem",
+		MeasureUpdate([&]() { registry.GetSystem<GetComponentMovementSystem>().Update(deltaTime); }),
+		MeasureUpdate([&]() { registry.GetSystem<MovementSystem>().Update(deltaTime, jobSystem); }));
+	PrintRow("RenderSystem",
+		MeasureUpdate([&]() { registry.GetSystem<GetComponentRenderSystem>().Update(camera); }),
+		MeasureUpdate([&]() { registry.GetSystem<ViewRenderSystem>().Update(camera); }));
+	PrintRow("CollisionSystem",
+		MeasureUpdate([&]() { registry.GetSystem<GetComponentCollisionSystem>().Update(eventBus); }),
+		MeasureUpdate([&]() { registry.GetSystem<CollisionSystem>().Update(eventBus); }));
+	PrintRow("RenderHealthBarSystem",
+		MeasureUpdate([&]() { registry.GetSystem<GetComponentHealthBarSystem>().Update(camera); }),
+		MeasureUpdate([&]() { registry.GetSystem<ViewHealthBarSystem>().Update(camera); }));
+}
+
+int main() {
+	// the collision loop tests every pair, so it gets fewer entities than the others
+	RunBenchmark(StorageMode::Pools, 100000, 2000);
+	RunBenchmark(StorageMode::Archetypes, 100000, 2000);
+	return 0;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SDL.h>
+#include "../ECS/Reflection.hpp"
 
 struct AnimationComponent {
 	int numFrames;
@@ -16,4 +17,11 @@ struct AnimationComponent {
 		this->isLoop = isLoop;
 		this->startTime = SDL_GetTicks();
 	}
-};
\ No newline at end of file
+};
+
+REFLECT_COMPONENT(AnimationComponent,
+	REFLECT_FIELD(AnimationComponent, numFrames),
+	REFLECT_FIELD(AnimationComponent, currentFrame),
+	REFLECT_FIELD(AnimationComponent, frameSpeedRate),
+	REFLECT_FIELD(AnimationComponent, isLoop),
+	REFLECT_FIELD(AnimationComponent, startTime))
\ No newline at end of file
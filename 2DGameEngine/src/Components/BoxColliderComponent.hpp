@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include "../ECS/Reflection.hpp"
 
 struct BoxColliderComponent {
 	int width;
@@ -12,4 +13,9 @@ struct BoxColliderComponent {
 		this->height = height;
 		this->offset = offset;
 	}
-};
\ No newline at end of file
+};
+
+REFLECT_COMPONENT(BoxColliderComponent,
+	REFLECT_FIELD(BoxColliderComponent, width),
+	REFLECT_FIELD(BoxColliderComponent, height),
+	REFLECT_FIELD(BoxColliderComponent, offset))
\ No newline at end of file
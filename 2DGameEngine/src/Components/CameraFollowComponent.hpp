@@ -1,5 +1,9 @@
 #pragma once
 
+#include "../ECS/Reflection.hpp"
+
 struct CameraFollowComponent {
 	CameraFollowComponent() = default;
-};
\ No newline at end of file
+};
+
+REFLECT_COMPONENT(CameraFollowComponent)
\ No newline at end of file
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "../ECS/Reflection.hpp"
+
 struct HealthComponent {
 	int healthPercentage;
 
 	HealthComponent(int healthPercentage = 0) {
 		this->healthPercentage = healthPercentage;
 	}
-};
\ No newline at end of file
+};
+
+REFLECT_COMPONENT(HealthComponent,
+	REFLECT_FIELD(HealthComponent, healthPercentage))
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include "../ECS/Reflection.hpp"
 
 struct KeyboardControlledComponent {
 	glm::vec2 upVelocity;
@@ -14,4 +15,10 @@ struct KeyboardControlledComponent {
 		this->downVelocity = downVelocity;
 		this->leftVelocity = leftVelocity;
 	}
-};
\ No newline at end of file
+};
+
+REFLECT_COMPONENT(KeyboardControlledComponent,
+	REFLECT_FIELD(KeyboardControlledComponent, upVelocity),
+	REFLECT_FIELD(KeyboardControlledComponent, rightVelocity),
+	REFLECT_FIELD(KeyboardControlledComponent, downVelocity),
+	REFLECT_FIELD(KeyboardControlledComponent, leftVelocity))
\ No newline at end of file
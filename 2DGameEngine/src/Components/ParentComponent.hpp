@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <limits>
+#include "../ECS/ECS.hpp"
+#include "../ECS/Reflection.hpp"
+
+/*
+ ParentComponent
+ Attaches an entity to a parent entity. The local transform is relative to the
+ parent's transform, TransformSystem writes the resulting world transform into the
+ entity's TransformComponent, so attached entities are moved through their local
+ transform. Killing a parent leaves its children where they are
+*/
+struct ParentComponent {
+	static constexpr EntityHandle NO_PARENT = std::numeric_limits<EntityHandle>::max();
+
+	EntityHandle parent;
+	glm::vec2 localPosition;
+	glm::vec2 localScale;
+	double localRotation;
+
+	ParentComponent(EntityHandle parent = NO_PARENT, glm::vec2 localPosition = glm::vec2(0, 0), glm::vec2 localScale = glm::vec2(1, 1), double localRotation = 0) {
+		this->parent = parent;
+		this->localPosition = localPosition;
+		this->localScale = localScale;
+		this->localRotation = localRotation;
+	}
+
+	ParentComponent(Entity parent, glm::vec2 localPosition = glm::vec2(0, 0), glm::vec2 localScale = glm::vec2(1, 1), double localRotation = 0)
+		: ParentComponent(parent.GetHandle(), localPosition, localScale, localRotation) {}
+};
+
+REFLECT_COMPONENT(ParentComponent,
+	REFLECT_FIELD(ParentComponent, parent),
+	REFLECT_FIELD(ParentComponent, localPosition),
+	REFLECT_FIELD(ParentComponent, localScale),
+	REFLECT_FIELD(ParentComponent, localRotation))
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <SDL.h>
+#include "../ECS/Reflection.hpp"
 
 struct ProjectileComponent {
 	bool isFriendly;
@@ -14,4 +15,10 @@ struct ProjectileComponent {
 		this->duration = duration;
 		this->startTime = SDL_GetTicks();
 	}
-};
\ No newline at end of file
+};
+
+REFLECT_COMPONENT(ProjectileComponent,
+	REFLECT_FIELD(ProjectileComponent, isFriendly),
+	REFLECT_FIELD(ProjectileComponent, hitPercentDamage),
+	REFLECT_FIELD(ProjectileComponent, duration),
+	REFLECT_FIELD(ProjectileComponent, startTime))
\ No newline at end of file
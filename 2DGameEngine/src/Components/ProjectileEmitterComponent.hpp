@@ -2,6 +2,7 @@
 
 #include <SDL.h>
 #include <glm/glm.hpp>
+#include "../ECS/Reflection.hpp"
 
 struct ProjectileEmitterComponent {
     glm::vec2 projectileVelocity;
@@ -19,4 +20,12 @@ struct ProjectileEmitterComponent {
         this->isFriendly = isFriendly;
         this->lastEmissionTime = SDL_GetTicks();
     }
-};
\ No newline at end of file
+};
+
+REFLECT_COMPONENT(ProjectileEmitterComponent,
+    REFLECT_FIELD(ProjectileEmitterComponent, projectileVelocity),
+    REFLECT_FIELD(ProjectileEmitterComponent, repeatFrequency),
+    REFLECT_FIELD(ProjectileEmitterComponent, projectileDuration),
+    REFLECT_FIELD(ProjectileEmitterComponent, hitPercentDamage),
+    REFLECT_FIELD(ProjectileEmitterComponent, isFriendly),
+    REFLECT_FIELD(ProjectileEmitterComponent, lastEmissionTime))
\ No newline at end of file
@@ -1,10 +1,93 @@
 #pragma once
 #include <glm/glm.hpp>
+#include "../ECS/SoAPool.hpp"
 
 struct RigidBodyComponent{
 	glm::vec2 velocity;
+	glm::vec2 acceleration;
+	// linear damping, the velocity is divided by (1 + damping * deltaTime) every step
+	float damping;
 
-	RigidBodyComponent(glm::vec2 velocity = glm::vec2(0.0, 0.0)) {
+	RigidBodyComponent(glm::vec2 velocity = glm::vec2(0.0, 0.0), glm::vec2 acceleration = glm::vec2(0.0, 0.0), float damping = 0.0f) {
 		this->velocity = velocity;
+		this->acceleration = acceleration;
+		this->damping = damping;
 	}
-};
\ No newline at end of file
+};
+
+REFLECT_COMPONENT(RigidBodyComponent,
+	REFLECT_FIELD(RigidBodyComponent, velocity),
+	REFLECT_FIELD(RigidBodyComponent, acceleration),
+	REFLECT_FIELD(RigidBodyComponent, damping))
+
+/*
+ RigidBodyReference
+ What GetMutableComponent<RigidBodyComponent>() returns, the fields refer to the pool
+ arrays or to the component itself with archetype storage, see TransformReference
+*/
+struct RigidBodyReference {
+	Vec2Reference velocity;
+	Vec2Reference acceleration;
+	float& damping;
+
+	RigidBodyReference(Vec2Reference velocity, Vec2Reference acceleration, float& damping) : velocity(velocity), acceleration(acceleration), damping(damping) {}
+	RigidBodyReference(RigidBodyComponent& rigidBody) : velocity(rigidBody.velocity), acceleration(rigidBody.acceleration), damping(rigidBody.damping) {}
+	RigidBodyReference(const RigidBodyReference& other) = default;
+
+	operator RigidBodyComponent() const {
+		return RigidBodyComponent(velocity, acceleration, damping);
+	}
+
+	RigidBodyReference& operator = (const RigidBodyComponent& rigidBody) {
+		velocity = rigidBody.velocity;
+		acceleration = rigidBody.acceleration;
+		damping = rigidBody.damping;
+		return *this;
+	}
+
+	RigidBodyReference& operator = (const RigidBodyReference& other) {
+		return *this = RigidBodyComponent(other);
+	}
+};
+
+// rigid body fields stored as separate arrays, see SoAPool
+struct RigidBodyColumns {
+	using Reference = RigidBodyReference;
+
+	AlignedArray<float> velocityX;
+	AlignedArray<float> velocityY;
+	AlignedArray<float> accelerationX;
+	AlignedArray<float> accelerationY;
+	AlignedArray<float> damping;
+
+	template <typename TFunc>
+	void ForEachColumn(TFunc func) {
+		func(velocityX);
+		func(velocityY);
+		func(accelerationX);
+		func(accelerationY);
+		func(damping);
+	}
+
+	void Store(int index, const RigidBodyComponent& rigidBody) {
+		velocityX[index] = rigidBody.velocity.x;
+		velocityY[index] = rigidBody.velocity.y;
+		accelerationX[index] = rigidBody.acceleration.x;
+		accelerationY[index] = rigidBody.acceleration.y;
+		damping[index] = rigidBody.damping;
+	}
+
+	RigidBodyComponent Load(int index) const {
+		return RigidBodyComponent(glm::vec2(velocityX[index], velocityY[index]), glm::vec2(accelerationX[index], accelerationY[index]), damping[index]);
+	}
+
+	Reference GetReference(int index) {
+		return Reference(Vec2Reference(velocityX[index], velocityY[index]), Vec2Reference(accelerationX[index], accelerationY[index]), damping[index]);
+	}
+};
+
+template <>
+class Pool<RigidBodyComponent> : public SoAPool<RigidBodyComponent, RigidBodyColumns> {
+public:
+	using SoAPool::SoAPool;
+};
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <SDL.h>
+#include "../ECS/Reflection.hpp"
 
 struct SpriteComponent {
 	std::string assetId;
@@ -19,4 +20,12 @@ struct SpriteComponent {
 		this->isFixed = isFixed;
 		this->src = { srcX, srcY, width, height };
 	}
-};
\ No newline at end of file
+};
+
+REFLECT_COMPONENT(SpriteComponent,
+	REFLECT_FIELD(SpriteComponent, assetId),
+	REFLECT_FIELD(SpriteComponent, width),
+	REFLECT_FIELD(SpriteComponent, height),
+	REFLECT_FIELD(SpriteComponent, zIndex),
+	REFLECT_FIELD(SpriteComponent, isFixed),
+	REFLECT_FIELD(SpriteComponent, src))
\ No newline at end of file
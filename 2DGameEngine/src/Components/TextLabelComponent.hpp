@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 #include <string>
 #include <SDL.h>
+#include "../ECS/Reflection.hpp"
 
 struct TextLabelComponent {
 
@@ -19,4 +20,11 @@ struct TextLabelComponent {
 		this->color = color;
 		this->isFixed = isFixed;
 	}
-};
\ No newline at end of file
+};
+
+REFLECT_COMPONENT(TextLabelComponent,
+	REFLECT_FIELD(TextLabelComponent, position),
+	REFLECT_FIELD(TextLabelComponent, text),
+	REFLECT_FIELD(TextLabelComponent, assetId),
+	REFLECT_FIELD(TextLabelComponent, color),
+	REFLECT_FIELD(TextLabelComponent, isFixed))
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include "../ECS/SoAPool.hpp"
 
 struct TransformComponent {
 	glm::vec2 position;
@@ -12,4 +13,83 @@ struct TransformComponent {
 		this->scale = scale;
 		this->rotation = rotation;
 	}
-};
\ No newline at end of file
+};
+
+REFLECT_COMPONENT(TransformComponent,
+	REFLECT_FIELD(TransformComponent, position),
+	REFLECT_FIELD(TransformComponent, scale),
+	REFLECT_FIELD(TransformComponent, rotation))
+
+/*
+ TransformReference
+ What GetMutableComponent<TransformComponent>() returns. The fields refer to the
+ pool arrays, or to the component itself with archetype storage, so call sites read
+ and write transform.position.x as before. Binding it to a const TransformComponent&
+ takes a copy, which is what GetComponent<TransformComponent>() returns
+*/
+struct TransformReference {
+	Vec2Reference position;
+	Vec2Reference scale;
+	double& rotation;
+
+	TransformReference(Vec2Reference position, Vec2Reference scale, double& rotation) : position(position), scale(scale), rotation(rotation) {}
+	TransformReference(TransformComponent& transform) : position(transform.position), scale(transform.scale), rotation(transform.rotation) {}
+	TransformReference(const TransformReference& other) = default;
+
+	operator TransformComponent() const {
+		return TransformComponent(position, scale, rotation);
+	}
+
+	TransformReference& operator = (const TransformComponent& transform) {
+		position = transform.position;
+		scale = transform.scale;
+		rotation = transform.rotation;
+		return *this;
+	}
+
+	TransformReference& operator = (const TransformReference& other) {
+		return *this = TransformComponent(other);
+	}
+};
+
+// transform fields stored as separate arrays, see SoAPool
+struct TransformColumns {
+	using Reference = TransformReference;
+
+	AlignedArray<float> positionX;
+	AlignedArray<float> positionY;
+	AlignedArray<float> scaleX;
+	AlignedArray<float> scaleY;
+	AlignedArray<double> rotation;
+
+	template <typename TFunc>
+	void ForEachColumn(TFunc func) {
+		func(positionX);
+		func(positionY);
+		func(scaleX);
+		func(scaleY);
+		func(rotation);
+	}
+
+	void Store(int index, const TransformComponent& transform) {
+		positionX[index] = transform.position.x;
+		positionY[index] = transform.position.y;
+		scaleX[index] = transform.scale.x;
+		scaleY[index] = transform.scale.y;
+		rotation[index] = transform.rotation;
+	}
+
+	TransformComponent Load(int index) const {
+		return TransformComponent(glm::vec2(positionX[index], positionY[index]), glm::vec2(scaleX[index], scaleY[index]), rotation[index]);
+	}
+
+	Reference GetReference(int index) {
+		return Reference(Vec2Reference(positionX[index], positionY[index]), Vec2Reference(scaleX[index], scaleY[index]), rotation[index]);
+	}
+};
+
+template <>
+class Pool<TransformComponent> : public SoAPool<TransformComponent, TransformColumns> {
+public:
+	using SoAPool::SoAPool;
+};
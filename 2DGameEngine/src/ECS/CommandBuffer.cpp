@@ -0,0 +1,102 @@
+#include "CommandBuffer.hpp"
+
+CommandBuffer::~CommandBuffer() {
+	Reset();
+}
+
+bool CommandBuffer::IsTemporary(Entity entity) {
+	return entity.GetGeneration() == TEMPORARY_GENERATION;
+}
+
+Entity CommandBuffer::CreateEntity() {
+	Entity entity(temporaryCount++, TEMPORARY_GENERATION);
+	Record(entity, nullptr, nullptr, nullptr);
+	return entity;
+}
+
+void CommandBuffer::KillEntity(Entity entity) {
+	Record(entity,
+		[](Registry& registry, Entity target, void*) { registry.KillEntity(target); },
+		nullptr, nullptr);
+}
+
+void CommandBuffer::Tag(Entity entity, const std::string& tag) {
+	Record(entity,
+		[](Registry& registry, Entity target, void* payload) { registry.TagEntity(target, *static_cast<std::string*>(payload)); },
+		[](void* payload) { static_cast<std::string*>(payload)->~basic_string(); },
+		Construct<std::string>(tag));
+}
+
+void CommandBuffer::Group(Entity entity, const std::string& group) {
+	Record(entity,
+		[](Registry& registry, Entity target, void* payload) { registry.GroupEntity(target, *static_cast<std::string*>(payload)); },
+		[](void* payload) { static_cast<std::string*>(payload)->~basic_string(); },
+		Construct<std::string>(group));
+}
+
+bool CommandBuffer::IsEmpty() const {
+	return commands.empty();
+}
+
+void CommandBuffer::Record(Entity entity, void (*apply)(Registry&, Entity, void*), void (*destroy)(void*), void* payload) {
+	commands.push_back({ JobOrder::GetKey(), entity.GetHandle(), apply, destroy, payload });
+}
+
+void* CommandBuffer::Allocate(size_t size, size_t alignment) {
+	while (true) {
+		if (blockIndex < blocks.size()) {
+			Block& block = blocks[blockIndex];
+			const uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+			const uintptr_t start = (base + blockOffset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+			if (start + size <= base + block.size) {
+				blockOffset = start - base + size;
+				return reinterpret_cast<void*>(start);
+			}
+			blockIndex++;
+			blockOffset = 0;
+			continue;
+		}
+		// payloads bigger than a block get a block of their own
+		const size_t blockSize = std::max(BLOCK_SIZE, size + alignment);
+		blocks.push_back({ std::make_unique<std::byte[]>(blockSize), blockSize });
+	}
+}
+
+Entity CommandBuffer::Resolve(Registry& registry, EntityHandle handle) const {
+	Entity entity(handle);
+	if (IsTemporary(entity)) {
+		entity = Entity(createdEntities[entity.GetId()]);
+	}
+	entity.registry = &registry;
+	return entity;
+}
+
+void CommandBuffer::Apply(Registry& registry, const Command& command) {
+	if (!command.apply) {
+		Entity temporary(command.entity);
+		if (createdEntities.size() <= temporary.GetId()) {
+			createdEntities.resize(temporary.GetId() + 1);
+		}
+		createdEntities[temporary.GetId()] = registry.CreateEntity().GetHandle();
+		return;
+	}
+
+	const Entity entity = Resolve(registry, command.entity);
+	// commands for entities killed before the buffer was applied are dropped
+	if (registry.IsEntityAlive(entity)) {
+		command.apply(registry, entity, command.payload);
+	}
+}
+
+void CommandBuffer::Reset() {
+	for (const Command& command : commands) {
+		if (command.destroy) {
+			command.destroy(command.payload);
+		}
+	}
+	commands.clear();
+	createdEntities.clear();
+	temporaryCount = 0;
+	blockIndex = 0;
+	blockOffset = 0;
+}
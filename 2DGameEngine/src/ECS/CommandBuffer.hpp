@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ECS.hpp"
+#include "Prefab.hpp"
+#include "../JobSystem/JobSystem.hpp"
+
+/*
+ CommandBuffer
+ Records structural changes (create, add and remove components, kill, tag and
+ group) so systems running on worker threads can request them without touching
+ the registry. Every thread gets its own buffer from Registry::GetCommandBuffer()
+ and the registry applies all buffers at the start of its next Update().
+
+ CreateEntity() returns a temporary entity that is only valid as an argument to
+ the same buffer, it becomes a real entity when the buffer is applied.
+ Every command takes the JobOrder key of the thread that records it, commands
+ are applied in key order, then in the order they were recorded, so the result
+ doesn't depend on which thread ran first
+*/
+class CommandBuffer {
+public:
+	// generation used by temporary entities, real entities never reach it
+	static constexpr std::uint32_t TEMPORARY_GENERATION = 0xFFFFFFFF;
+	static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+	CommandBuffer() = default;
+	~CommandBuffer();
+
+	CommandBuffer(const CommandBuffer&) = delete;
+	CommandBuffer& operator = (const CommandBuffer&) = delete;
+
+	Entity CreateEntity();
+	// temporary entity that is created from the prefab, the prefab must outlive the next registry Update()
+	template <typename ...TOverrides> Entity Instantiate(const Prefab& prefab, TOverrides&& ...overrides);
+	template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
+	template <typename TComponent> void RemoveComponent(Entity entity);
+	void KillEntity(Entity entity);
+	void Tag(Entity entity, const std::string& tag);
+	void Group(Entity entity, const std::string& group);
+
+	bool IsEmpty() const;
+
+	static bool IsTemporary(Entity entity);
+
+private:
+	friend class Registry;
+
+	struct Command {
+		std::uint64_t sortKey;
+		EntityHandle entity;
+		// nullptr creates the temporary entity
+		void (*apply)(Registry& registry, Entity entity, void* payload);
+		void (*destroy)(void* payload);
+		void* payload;
+	};
+
+	template <typename ...TOverrides>
+	struct PrefabPayload {
+		template <typename ...TArgs>
+		PrefabPayload(const Prefab* prefab, TArgs&& ...args) : prefab(prefab), overrides(std::forward<TArgs>(args)...) {}
+
+		const Prefab* prefab;
+		std::tuple<TOverrides...> overrides;
+	};
+
+	// payload memory comes from blocks that are kept between frames, so objects never move
+	struct Block {
+		std::unique_ptr<std::byte[]> memory;
+		size_t size;
+	};
+
+	template <typename T, typename ...TArgs> T* Construct(TArgs&& ...args);
+	void* Allocate(size_t size, size_t alignment);
+	void Record(Entity entity, void (*apply)(Registry&, Entity, void*), void (*destroy)(void*), void* payload);
+
+	// turn a temporary entity into the entity created for it, only valid while applying
+	Entity Resolve(Registry& registry, EntityHandle handle) const;
+	void Apply(Registry& registry, const Command& command);
+	void Reset();
+
+	std::vector<Command> commands;
+	// handles of the created entities, index = temporary entity id
+	std::vector<EntityHandle> createdEntities;
+	int temporaryCount = 0;
+
+	std::vector<Block> blocks;
+	size_t blockIndex = 0;
+	size_t blockOffset = 0;
+};
+
+template <typename T, typename ...TArgs>
+T* CommandBuffer::Construct(TArgs&& ...args) {
+	return new (Allocate(sizeof(T), alignof(T))) T(std::forward<TArgs>(args)...);
+}
+
+template <typename ...TOverrides>
+Entity CommandBuffer::Instantiate(const Prefab& prefab, TOverrides&& ...overrides) {
+	using Payload = PrefabPayload<std::decay_t<TOverrides>...>;
+	Entity entity = CreateEntity();
+	Payload* payload = Construct<Payload>(&prefab, std::forward<TOverrides>(overrides)...);
+	Record(entity,
+		[](Registry& registry, Entity target, void* payload) {
+			Payload& prefabPayload = *static_cast<Payload*>(payload);
+			std::apply([&registry, target, &prefabPayload](auto& ...overrides) {
+				registry.ApplyPrefab(target, *prefabPayload.prefab, std::move(overrides)...);
+			}, prefabPayload.overrides);
+		},
+		[](void* payload) { static_cast<Payload*>(payload)->~Payload(); },
+		payload);
+	return entity;
+}
+
+template <typename TComponent, typename ...TArgs>
+void CommandBuffer::AddComponent(Entity entity, TArgs&& ...args) {
+	TComponent* component = Construct<TComponent>(std::forward<TArgs>(args)...);
+	Record(entity,
+		[](Registry& registry, Entity target, void* payload) {
+			registry.AddComponent<TComponent>(target, std::move(*static_cast<TComponent*>(payload)));
+		},
+		[](void* payload) { static_cast<TComponent*>(payload)->~TComponent(); },
+		component);
+}
+
+template <typename TComponent>
+void CommandBuffer::RemoveComponent(Entity entity) {
+	Record(entity,
+		[](Registry& registry, Entity target, void*) { registry.RemoveComponent<TComponent>(target); },
+		nullptr, nullptr);
+}
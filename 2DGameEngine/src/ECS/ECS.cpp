@@ -1,12 +1,110 @@
 #include "ECS.hpp"
+#include "CommandBuffer.hpp"
+#include "Prefab.hpp"
 #include "../Logger/Logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <mutex>
 
 int IComponent::nextId;
 
-int Entity::GetId() const{
+// Type information per component id, vector index = component id
+static std::deque<ComponentInfo>& ComponentInfos() {
+	static std::deque<ComponentInfo> componentInfos;
+	return componentInfos;
+}
+
+static std::mutex componentInfoMutex;
+
+int IComponent::Register(const ComponentInfo& info) {
+	std::lock_guard<std::mutex> lock(componentInfoMutex);
+	if (nextId >= MAX_COMPONENTS) {
+		// a larger id would index past the end of every signature and archetype table
+		Logger::Err("Component " + std::string(info.name) + " doesn't fit in a signature, raise ECS_MAX_COMPONENTS above " + std::to_string(MAX_COMPONENTS));
+		std::abort();
+	}
+	ComponentInfos().push_back(info);
+	return nextId++;
+}
+
+const ComponentInfo& IComponent::GetInfo(int componentId) {
+	return ComponentInfos()[componentId];
+}
+
+int IComponent::GetCount() {
+	std::lock_guard<std::mutex> lock(componentInfoMutex);
+	return nextId;
+}
+
+int IComponent::FindId(const std::string& name) {
+	std::lock_guard<std::mutex> lock(componentInfoMutex);
+	for (int componentId = 0; componentId < nextId; componentId++) {
+		if (name == ComponentInfos()[componentId].name) {
+			return componentId;
+		}
+	}
+	return -1;
+}
+
+// Interned tag or group names, the index of a name in names is its id
+struct InternedNames {
+	std::unordered_map<std::string, int> ids;
+	std::deque<std::string> names;
+	std::mutex mutex;
+};
+
+static InternedNames& TagNames() {
+	static InternedNames tagNames;
+	return tagNames;
+}
+
+static InternedNames& GroupNames() {
+	static InternedNames groupNames;
+	return groupNames;
+}
+
+// id of the name, assigned the first time it is used, -1 if maxCount names are in use
+static int InternName(InternedNames& internedNames, const std::string& name, size_t maxCount) {
+	std::lock_guard<std::mutex> lock(internedNames.mutex);
+	auto interned = internedNames.ids.find(name);
+	if (interned != internedNames.ids.end()) {
+		return interned->second;
+	}
+	if (internedNames.names.size() >= maxCount) {
+		return -1;
+	}
+	const int id = static_cast<int>(internedNames.names.size());
+	internedNames.ids.emplace(name, id);
+	internedNames.names.push_back(name);
 	return id;
 }
 
+// id of a name that was interned before, -1 if it never was
+static int FindName(InternedNames& internedNames, const std::string& name) {
+	std::lock_guard<std::mutex> lock(internedNames.mutex);
+	auto interned = internedNames.ids.find(name);
+	return interned != internedNames.ids.end() ? interned->second : -1;
+}
+
+int Entity::GetId() const{
+	return static_cast<int>(handle & 0xFFFFFFFF);
+}
+
+std::uint32_t Entity::GetGeneration() const {
+	return static_cast<std::uint32_t>(handle >> 32);
+}
+
+EntityHandle Entity::GetHandle() const {
+	return handle;
+}
+
+bool Entity::IsAlive() const {
+	return registry->IsEntityAlive(*this);
+}
+
 void Entity::Kill() {
 	registry->KillEntity(*this);
 }
@@ -19,6 +117,10 @@ bool Entity::HasTag(const std::string& tag) const {
 	return registry->EntityHasTag(*this, tag);
 }
 
+bool Entity::HasTag(int tagId) const {
+	return registry->EntityHasTag(*this, tagId);
+}
+
 void Entity::Group(const std::string& group) {
 	registry->GroupEntity(*this, group);
 }
@@ -27,32 +129,391 @@ bool Entity::BelongsToGroup(const std::string& group) const{
 	return registry->EntityBelongsToGroup(*this, group);
 }
 
+bool Entity::BelongsToGroup(int groupId) const {
+	return registry->EntityBelongsToGroup(*this, groupId);
+}
+
 void System::AddEntityToSystem(Entity entity) {
-	entities.push_back(entity);
+	entities.Set(entity.GetId(), entity.GetHandle());
 }
 
 void System::RemoveEntityFromSystem(Entity entity) {
-	entities.erase(std::remove_if(entities.begin(), entities.end(), [&entity](Entity& other) {
-		return entity == other;
-		}), entities.end());
+	if (HasEntity(entity)) {
+		entities.Remove(entity.GetId());
+	}
 }
 
-std::vector<Entity> System::GetSystemEntities() const {
-	return entities;
+void System::RemoveEntitiesFromSystem(const std::vector<Entity>& entitiesToRemove) {
+	for (Entity entity : entitiesToRemove) {
+		RemoveEntityFromSystem(entity);
+	}
+}
+
+void System::RemoveAllEntitiesFromSystem() {
+	entities.Clear();
+}
+
+bool System::HasEntity(Entity entity) const {
+	return entities.Contains(entity.GetId()) && entities.GetData()[entities.IndexOf(entity.GetId())] == entity.GetHandle();
+}
+
+SystemEntities System::GetSystemEntities() const {
+	return SystemEntities(entities.GetData(), registry);
+}
+
+int System::GetEntityCount() const {
+	return entities.GetSize();
+}
+
+size_t System::GetEntityBytes() const {
+	return entities.GetBytes();
+}
+
+std::uint32_t System::GetEntityLayoutVersion() const {
+	return entities.GetLayoutVersion();
+}
+
+void System::SetComponentPools(const std::vector<IPool*>& pools) {
+	componentPools = pools;
+}
+
+void System::MarkRun() {
+	lastRunTick = registry->GetTick();
 }
 
 const Signature& System::GetComponentSignature() const {
 	return componentSignature;
 }
 
-Entity Registry::CreateEntity() {
+void System::RequireExclusiveAccess() {
+	exclusiveAccess = true;
+}
+
+const Signature& System::GetReadSignature() const {
+	return readSignature;
+}
+
+const Signature& System::GetWriteSignature() const {
+	return writeSignature;
+}
+
+bool System::HasExclusiveAccess() const {
+	return exclusiveAccess;
+}
+
+bool System::ConflictsWith(const System& other) const {
+	if (exclusiveAccess || other.exclusiveAccess) {
+		return true;
+	}
+	return writeSignature.Intersects(other.readSignature) || writeSignature.Intersects(other.writeSignature)
+		|| other.writeSignature.Intersects(readSignature);
+}
+
+Archetype::Archetype(const Signature& signature) : signature(signature) {
+	columnPerComponent.fill(-1);
+
+	size_t rowSize = sizeof(EntityHandle);
+	for (int componentId = 0; componentId < MAX_COMPONENTS; componentId++) {
+		if (signature.test(componentId)) {
+			columnPerComponent[componentId] = static_cast<int>(componentIds.size());
+			componentIds.push_back(componentId);
+			columnSizes.push_back(IComponent::GetInfo(componentId).size);
+			rowSize += IComponent::GetInfo(componentId).size;
+		}
+	}
+
+	// fit as many rows as possible in a chunk, leaving room for column alignment
+	chunkCapacity = std::max(1, static_cast<int>(CHUNK_SIZE / rowSize));
+	while (chunkCapacity > 1 && !LayoutColumns(chunkCapacity)) {
+		chunkCapacity--;
+	}
+	if (!LayoutColumns(chunkCapacity)) {
+		// a single row is bigger than a chunk, so grow the chunk to fit it
+		chunkBytes = columnOffsets.back() + columnSizes.back();
+	}
+}
+
+Archetype::~Archetype() {
+	for (std::byte* chunk : chunks) {
+		::operator delete(chunk, std::align_val_t(CHUNK_ALIGNMENT));
+	}
+}
+
+bool Archetype::LayoutColumns(int capacity) {
+	columnOffsets.clear();
+	size_t offset = sizeof(EntityHandle) * capacity;
+	for (int componentId : componentIds) {
+		const size_t alignment = IComponent::GetInfo(componentId).alignment;
+		offset = (offset + alignment - 1) / alignment * alignment;
+		columnOffsets.push_back(offset);
+		offset += IComponent::GetInfo(componentId).size * capacity;
+	}
+	return offset <= chunkBytes;
+}
+
+int Archetype::PushRow(EntityHandle handle) {
+	if (entityCount == static_cast<int>(chunks.size()) * chunkCapacity) {
+		chunks.push_back(static_cast<std::byte*>(::operator new(chunkBytes, std::align_val_t(CHUNK_ALIGNMENT))));
+	}
+	const int row = entityCount++;
+	GetHandles(row / chunkCapacity)[row % chunkCapacity] = handle;
+	return row;
+}
+
+EntityHandle Archetype::EraseRow(int row) {
+	const int lastRow = entityCount - 1;
+	EntityHandle movedHandle = GetHandle(row);
+
+	if (row != lastRow) {
+		// move the last row into the hole to keep the chunks packed
+		for (int componentId : componentIds) {
+			const ComponentInfo& info = IComponent::GetInfo(componentId);
+			void* last = GetComponent(lastRow, componentId);
+			info.moveConstruct(GetComponent(row, componentId), last);
+			info.destroy(last);
+		}
+		movedHandle = GetHandle(lastRow);
+		GetHandles(row / chunkCapacity)[row % chunkCapacity] = movedHandle;
+	}
+	entityCount--;
+
+	// release the last chunk once it is empty
+	if (entityCount == (static_cast<int>(chunks.size()) - 1) * chunkCapacity) {
+		::operator delete(chunks.back(), std::align_val_t(CHUNK_ALIGNMENT));
+		chunks.pop_back();
+	}
+	return movedHandle;
+}
+
+Archetype* ArchetypeStorage::GetArchetype(const Signature& signature) {
+	auto archetype = archetypePerSignature.find(signature);
+	if (archetype != archetypePerSignature.end()) {
+		return archetype->second;
+	}
+	archetypes.push_back(std::make_unique<Archetype>(signature));
+	archetypePerSignature.emplace(signature, archetypes.back().get());
+	return archetypes.back().get();
+}
+
+void ArchetypeStorage::AddEntity(Entity entity) {
+	const int entityId = entity.GetId();
+	if (entityId >= entityLocations.size()) {
+		entityLocations.resize(entityId + 1);
+	}
+	Archetype* emptyArchetype = GetArchetype(Signature());
+	entityLocations[entityId] = { emptyArchetype, emptyArchetype->PushRow(entity.GetHandle()) };
+}
+
+void ArchetypeStorage::RemoveEntity(int entityId) {
+	EntityLocation& location = entityLocations[entityId];
+	DestroyRow(location.archetype, location.row);
+	location = EntityLocation();
+}
+
+void* ArchetypeStorage::AddComponent(int entityId, int componentId) {
+	Archetype* source = entityLocations[entityId].archetype;
+	Archetype*& target = source->addEdges[componentId];
+	if (!target) {
+		Signature signature = source->GetSignature();
+		signature.set(componentId);
+		target = GetArchetype(signature);
+		target->removeEdges[componentId] = source;
+	}
+	MoveEntity(entityId, target);
+	return target->GetComponent(entityLocations[entityId].row, componentId);
+}
+
+void ArchetypeStorage::AddComponents(int entityId, const Signature& components) {
+	Archetype* source = entityLocations[entityId].archetype;
+	const Signature signature = source->GetSignature() | components;
+	if (signature != source->GetSignature()) {
+		MoveEntity(entityId, GetArchetype(signature));
+	}
+}
+
+void ArchetypeStorage::RemoveComponent(int entityId, int componentId) {
+	Archetype* source = entityLocations[entityId].archetype;
+	Archetype*& target = source->removeEdges[componentId];
+	if (!target) {
+		Signature signature = source->GetSignature();
+		signature.reset(componentId);
+		target = GetArchetype(signature);
+		target->addEdges[componentId] = source;
+	}
+	MoveEntity(entityId, target);
+}
+
+void* ArchetypeStorage::GetComponent(int entityId, int componentId) const {
+	const EntityLocation& location = entityLocations[entityId];
+	return location.archetype->GetComponent(location.row, componentId);
+}
+
+void ArchetypeStorage::MoveEntity(int entityId, Archetype* target) {
+	EntityLocation& location = entityLocations[entityId];
+	Archetype* source = location.archetype;
+	const int sourceRow = location.row;
+	const int targetRow = target->PushRow(source->GetHandle(sourceRow));
+
+	for (int componentId : source->GetComponentIds()) {
+		const ComponentInfo& info = IComponent::GetInfo(componentId);
+		void* component = source->GetComponent(sourceRow, componentId);
+		if (target->GetSignature().test(componentId)) {
+			info.moveConstruct(target->GetComponent(targetRow, componentId), component);
+		}
+		info.destroy(component);
+	}
+
+	EraseRow(source, sourceRow);
+	location = { target, targetRow };
+}
+
+void ArchetypeStorage::DestroyRow(Archetype* archetype, int row) {
+	for (int componentId : archetype->GetComponentIds()) {
+		IComponent::GetInfo(componentId).destroy(archetype->GetComponent(row, componentId));
+	}
+	EraseRow(archetype, row);
+}
+
+void ArchetypeStorage::EraseRow(Archetype* archetype, int row) {
+	// the entity that filled the hole now lives in the erased row
+	const EntityHandle movedHandle = archetype->EraseRow(row);
+	const int movedEntityId = Entity(movedHandle).GetId();
+	if (entityLocations[movedEntityId].archetype == archetype) {
+		entityLocations[movedEntityId].row = row;
+	}
+}
+
+void ArchetypeStorage::Clear() {
+	for (auto& archetype : archetypes) {
+		for (int row = archetype->GetEntityCount() - 1; row >= 0; row--) {
+			for (int componentId : archetype->GetComponentIds()) {
+				IComponent::GetInfo(componentId).destroy(archetype->GetComponent(row, componentId));
+			}
+		}
+	}
+	archetypes.clear();
+	archetypePerSignature.clear();
+	entityLocations.clear();
+}
+
+void ArchetypeStorage::CopyFrom(const ArchetypeStorage& other) {
+	Clear();
+	entityLocations.resize(other.entityLocations.size());
+	for (const auto& source : other.archetypes) {
+		// same signature, so the copy gets the same chunk layout
+		Archetype* target = GetArchetype(source->GetSignature());
+		for (int row = 0; row < source->GetEntityCount(); row++) {
+			const EntityHandle handle = source->GetHandle(row);
+			const int targetRow = target->PushRow(handle);
+			for (int componentId : source->GetComponentIds()) {
+				IComponent::GetInfo(componentId).copyConstruct(target->GetComponent(targetRow, componentId), source->GetComponent(row, componentId));
+			}
+			entityLocations[Entity(handle).GetId()] = { target, targetRow };
+		}
+	}
+}
+
+ArchetypeStorage::~ArchetypeStorage() {
+	Clear();
+}
+
+// registry ids start at 1 so an empty thread cache never matches
+static std::atomic<std::uint64_t> nextRegistryId{ 1 };
+
+// the last few registries the current thread got a command buffer from, ids are never
+// reused so the entries of destroyed registries can't match and are replaced in turn
+struct ThreadCommandBuffer {
+	std::uint64_t registryId = 0;
+	CommandBuffer* buffer = nullptr;
+};
+static const int THREAD_COMMAND_BUFFER_CACHE_SIZE = 8;
+static thread_local std::array<ThreadCommandBuffer, THREAD_COMMAND_BUFFER_CACHE_SIZE> threadCommandBuffers;
+static thread_local int nextThreadCommandBuffer = 0;
+
+Registry::Registry(StorageMode storageMode) : storageMode(storageMode), registryId(nextRegistryId++) {
+	Logger::Log("Registry constuctor called");
+}
+
+Registry::~Registry() {
+	Logger::Log("Registry deconstuctor called");
+}
+
+CommandBuffer& Registry::GetCommandBuffer() {
+	for (const ThreadCommandBuffer& entry : threadCommandBuffers) {
+		if (entry.registryId == registryId) {
+			return *entry.buffer;
+		}
+	}
+
+	CommandBuffer* buffer;
+	{
+		std::lock_guard<std::mutex> lock(commandBuffersMutex);
+		auto found = threadBufferIndices.find(std::this_thread::get_id());
+		if (found != threadBufferIndices.end()) {
+			buffer = commandBuffers[found->second].get();
+		}
+		else {
+			threadBufferIndices.emplace(std::this_thread::get_id(), static_cast<int>(commandBuffers.size()));
+			commandBuffers.push_back(std::make_unique<CommandBuffer>());
+			buffer = commandBuffers.back().get();
+		}
+	}
+	threadCommandBuffers[nextThreadCommandBuffer] = { registryId, buffer };
+	nextThreadCommandBuffer = (nextThreadCommandBuffer + 1) % THREAD_COMMAND_BUFFER_CACHE_SIZE;
+	return *buffer;
+}
+
+void Registry::ApplyCommandBuffers() {
+	pendingCommands.clear();
+	for (int buffer = 0; buffer < commandBuffers.size(); buffer++) {
+		const std::vector<CommandBuffer::Command>& commands = commandBuffers[buffer]->commands;
+		for (int command = 0; command < commands.size(); command++) {
+			pendingCommands.push_back({ commands[command].sortKey, buffer, command });
+		}
+	}
+	if (pendingCommands.empty()) {
+		return;
+	}
+
+	// work the scheduler runs has a key per task and ParallelFor() chunk, so equal keys come
+	// from one thread and one buffer. The buffer only orders work recorded outside any scope
+	std::sort(pendingCommands.begin(), pendingCommands.end(), [](const PendingCommand& a, const PendingCommand& b) {
+		if (a.sortKey != b.sortKey) return a.sortKey < b.sortKey;
+		if (a.buffer != b.buffer) return a.buffer < b.buffer;
+		return a.command < b.command;
+	});
+
+	// create every entity first so later commands can always resolve temporary entities
+	for (const PendingCommand& pending : pendingCommands) {
+		const CommandBuffer::Command& command = commandBuffers[pending.buffer]->commands[pending.command];
+		if (!command.apply) {
+			commandBuffers[pending.buffer]->Apply(*this, command);
+		}
+	}
+	for (const PendingCommand& pending : pendingCommands) {
+		const CommandBuffer::Command& command = commandBuffers[pending.buffer]->commands[pending.command];
+		if (command.apply) {
+			commandBuffers[pending.buffer]->Apply(*this, command);
+		}
+	}
+
+	for (std::unique_ptr<CommandBuffer>& buffer : commandBuffers) {
+		buffer->Reset();
+	}
+}
+
+Entity Registry::AllocateEntity() {
 	int entityId;
 
 	if (freeIds.empty()) {
 		entityId = numEntities++;
 
-		if (entityId >= entityComponentSignatures.size()) {
-			entityComponentSignatures.resize(entityId + 1);
+		if (entityId >= entitySignatures.size()) {
+			entitySignatures.resize(entityId + 1, SignatureTable::EMPTY);
+			entityGenerations.resize(entityId + 1, 0);
+			entityMemberships.resize(entityId + 1);
+			entityTags.resize(entityId + 1, -1);
+			entityGroups.resize(entityId + 1);
 		}
 	}
 	else {
@@ -60,124 +521,1053 @@ Entity Registry::CreateEntity() {
 		freeIds.pop_front();
 	}
 
-	Entity entity(entityId);
+	Entity entity(entityId, entityGenerations[entityId]);
 	entity.registry = this;
-	entitiesToBeAdded.insert(entity);
 
-	Logger::Log("Entity created with id = " + std::to_string(entityId));
+	if (storageMode == StorageMode::Archetypes) {
+		archetypeStorage.AddEntity(entity);
+	}
+	MarkEntityDirty(entityId);
+	return entity;
+}
+
+Entity Registry::CreateEntity() {
+	Entity entity = AllocateEntity();
+
+	Logger::Log("Entity created with id = " + std::to_string(entity.GetId()));
 
 	return entity;
 }
 
+std::vector<Entity> Registry::CreateEntities(int count) {
+	std::vector<Entity> entities;
+	entities.reserve(count);
+
+	// grow the per entity arrays once instead of once per entity
+	const size_t newIds = count > freeIds.size() ? count - freeIds.size() : 0;
+	entitySignatures.reserve(numEntities + newIds);
+	entityGenerations.reserve(numEntities + newIds);
+	entityMemberships.reserve(numEntities + newIds);
+	entityTags.reserve(numEntities + newIds);
+	entityGroups.reserve(numEntities + newIds);
+	dirtyEntities.reserve(dirtyEntities.size() + count);
+
+	for (int i = 0; i < count; i++) {
+		entities.push_back(AllocateEntity());
+	}
+
+	Logger::Log(std::to_string(count) + " entities created");
+
+	return entities;
+}
+
 void Registry::KillEntity(Entity entity) {
-	entitiesToBeKilled.insert(entity);
+	// killing a stale handle must not kill the entity that reused its id
+	if (IsEntityAlive(entity)) {
+		// systems running in parallel can kill entities at the same time
+		std::lock_guard<std::mutex> lock(killMutex);
+		entitiesToBeKilled.insert(entity);
+	}
 }
 
-void Registry::AddEntityToSystems(Entity entity) {
+bool Registry::IsEntityAlive(Entity entity) const {
 	const int entityId = entity.GetId();
-	const Signature& entityComponentSignature = entityComponentSignatures[entityId];
+	return entityId < entityGenerations.size() && entityGenerations[entityId] == entity.GetGeneration();
+}
+
+Entity Registry::GetEntity(int entityId) {
+	Entity entity(entityId, entityGenerations[entityId]);
+	entity.registry = this;
+	return entity;
+}
+
+void Registry::Clear() {
+	for (int entityId = 0; entityId < numEntities; entityId++) {
+		const Signature& signature = GetEntitySignature(entityId);
+		for (int componentId = 0; componentId < componentObservers.size(); componentId++) {
+			if (signature.test(componentId)) {
+				QueueComponentEvent(componentId, ComponentEvent::Removed, GetEntity(entityId));
+			}
+		}
+	}
+
 	for (auto& system : systems) {
-		const Signature& systemComponentSignature = system.second->GetComponentSignature();
+		system.second->RemoveAllEntitiesFromSystem();
+	}
+	bool poolsReplaced = false;
+	for (int componentId = 0; componentId < componentPools.size(); componentId++) {
+		std::shared_ptr<IPool>& pool = componentPools[componentId];
+		if (pool && pool.use_count() > 1) {
+			// a clone still uses the pool, so start over with an empty one
+			pool.reset(IComponent::GetInfo(componentId).createPool());
+			poolsReplaced = true;
+		}
+		else if (pool) {
+			pool->Clear();
+		}
+	}
+	if (poolsReplaced) {
+		for (auto& system : systems) {
+			CacheSystemPools(*system.second);
+		}
+	}
+	archetypeStorage.Clear();
+
+	// every id becomes free, bumping the generations keeps handles to removed entities dead
+	freeIds.clear();
+	for (int entityId = 0; entityId < numEntities; entityId++) {
+		entityGenerations[entityId]++;
+		freeIds.push_back(entityId);
+		entitySignatures[entityId] = SignatureTable::EMPTY;
+		entityMemberships[entityId] = EntityMembership();
+	}
+	dirtyEntities.clear();
+	entitiesToBeKilled.clear();
+	for (std::unique_ptr<CommandBuffer>& buffer : commandBuffers) {
+		buffer->Reset();
+	}
 
-		bool isInterested = (entityComponentSignature & systemComponentSignature) == systemComponentSignature;
+	// the interned ids stay valid, only the members are dropped
+	std::fill(entityTags.begin(), entityTags.end(), -1);
+	std::fill(entityPerTag.begin(), entityPerTag.end(), std::nullopt);
+	std::fill(entityGroups.begin(), entityGroups.end(), GroupMask());
+	for (GroupMembers& group : entitiesPerGroup) {
+		group.entities.clear();
+		std::fill(group.entityIndices.begin(), group.entityIndices.end(), -1);
+	}
 
-		if (isInterested) {
-			system.second->AddEntityToSystem(entity);
+	Logger::Log("Registry cleared");
+}
+
+void Registry::ResolveSystemPools(System& system) {
+	// archetype storage has no pools, systems go through the registry instead
+	if (storageMode == StorageMode::Archetypes) {
+		return;
+	}
+
+	// the system may write these pools from any thread, so they can't stay shared with a clone
+	bool poolsCopied = false;
+	const Signature& writeSignature = system.GetWriteSignature();
+	for (int componentId = 0; componentId < componentPools.size(); componentId++) {
+		if (writeSignature.test(componentId)) {
+			poolsCopied = CopySharedPool(componentId) || poolsCopied;
 		}
 	}
+	if (poolsCopied) {
+		for (auto& otherSystem : systems) {
+			CacheSystemPools(*otherSystem.second);
+		}
+	}
+	CacheSystemPools(system);
+}
+
+void Registry::UnshareWrittenPools(const System& system) {
+	if (storageMode == StorageMode::Archetypes) {
+		return;
+	}
+	const Signature& writeSignature = system.GetWriteSignature();
+	for (int componentId = 0; componentId < componentPools.size(); componentId++) {
+		if (writeSignature.test(componentId) && componentPools[componentId]) {
+			UnsharePool(componentId);
+		}
+	}
+}
+
+void Registry::CacheSystemPools(System& system) {
+	if (storageMode == StorageMode::Archetypes) {
+		return;
+	}
+
+	const Signature& systemComponentSignature = system.GetComponentSignature();
+	std::vector<IPool*> systemPools;
+	for (int componentId = 0; componentId < MAX_COMPONENTS; componentId++) {
+		if (!systemComponentSignature.test(componentId)) {
+			continue;
+		}
+		if (componentId >= componentPools.size()) {
+			componentPools.resize(componentId + 1);
+		}
+		// create the pool up front so the cached pointer stays valid
+		if (!componentPools[componentId]) {
+			componentPools[componentId].reset(IComponent::GetInfo(componentId).createPool());
+		}
+		systemPools.resize(componentId + 1, nullptr);
+		systemPools[componentId] = componentPools[componentId].get();
+	}
+	system.SetComponentPools(systemPools);
+}
+
+bool Registry::CopySharedPool(int componentId) {
+	std::shared_ptr<IPool>& pool = componentPools[componentId];
+	if (!pool || pool.use_count() == 1) {
+		return false;
+	}
+	pool.reset(pool->Clone());
+	return true;
+}
+
+IPool* Registry::UnsharePool(int componentId) {
+	if (CopySharedPool(componentId)) {
+		// systems still point at the shared pool
+		for (auto& system : systems) {
+			if (system.second->GetComponentSignature().test(componentId)) {
+				CacheSystemPools(*system.second);
+			}
+		}
+	}
+	return componentPools[componentId].get();
+}
+
+std::unique_ptr<Registry> Registry::Clone() const {
+	// every component has to be copyable, either now or once a shared pool is changed
+	for (int componentId = 0; componentId < componentPools.size(); componentId++) {
+		if (componentPools[componentId] && !IComponent::GetInfo(componentId).copyConstruct) {
+			Logger::Err("Registry can't be cloned, component " + std::string(IComponent::GetInfo(componentId).name) + " can't be copied");
+			return nullptr;
+		}
+	}
+	for (const auto& archetype : archetypeStorage.GetArchetypes()) {
+		for (int componentId : archetype->GetComponentIds()) {
+			if (!IComponent::GetInfo(componentId).copyConstruct) {
+				Logger::Err("Registry can't be cloned, component " + std::string(IComponent::GetInfo(componentId).name) + " can't be copied");
+				return nullptr;
+			}
+		}
+	}
+	// the entities keep their system memberships, so every system has to come along
+	for (const auto& [type, system] : systems) {
+		if (!system->copySystem) {
+			Logger::Err("Registry can't be cloned, system " + std::string(type.name()) + " can't be copied");
+			return nullptr;
+		}
+	}
+
+	std::unique_ptr<Registry> clone = std::make_unique<Registry>(storageMode);
+	Registry* cloneRegistry = clone.get();
+	clone->numEntities = numEntities;
+	clone->currentTick = currentTick;
+	clone->entitySignatures = entitySignatures;
+	clone->signatureTable = signatureTable;
+	clone->entityGenerations = entityGenerations;
+	clone->entityMemberships = entityMemberships;
+	clone->dirtyEntities = dirtyEntities;
+	clone->freeIds = freeIds;
+
+	// entities remember their registry, the copies must point at the clone
+	auto cloneEntity = [cloneRegistry](Entity entity) {
+		entity.registry = cloneRegistry;
+		return entity;
+	};
+	for (Entity entity : entitiesToBeKilled) {
+		clone->entitiesToBeKilled.emplace_hint(clone->entitiesToBeKilled.end(), cloneEntity(entity));
+	}
+	clone->entityTags = entityTags;
+	clone->entityPerTag.reserve(entityPerTag.size());
+	for (const std::optional<Entity>& taggedEntity : entityPerTag) {
+		clone->entityPerTag.push_back(taggedEntity ? std::optional<Entity>(cloneEntity(*taggedEntity)) : std::nullopt);
+	}
+	clone->entityGroups = entityGroups;
+	for (int groupId = 0; groupId < MAX_GROUPS; groupId++) {
+		GroupMembers& cloneGroup = clone->entitiesPerGroup[groupId];
+		cloneGroup.entityIndices = entitiesPerGroup[groupId].entityIndices;
+		cloneGroup.entities.reserve(entitiesPerGroup[groupId].entities.size());
+		for (Entity entity : entitiesPerGroup[groupId].entities) {
+			cloneGroup.entities.push_back(cloneEntity(entity));
+		}
+	}
+
+	if (storageMode == StorageMode::Archetypes) {
+		clone->archetypeStorage.CopyFrom(archetypeStorage);
+	}
+	else {
+		// every pool is shared, the side that writes one first copies it
+		clone->componentPools = componentPools;
+	}
+
+	// copied systems keep their entities, so memberships stay valid
+	for (const auto& [type, system] : systems) {
+		std::unique_ptr<System> systemCopy(system->copySystem(*system));
+		systemCopy->registry = cloneRegistry;
+		clone->CacheSystemPools(*systemCopy);
+		clone->systems.emplace(type, std::move(systemCopy));
+	}
+
+	Logger::Log("Registry cloned with " + std::to_string(numEntities - static_cast<int>(freeIds.size())) + " entities");
+	return clone;
+}
+
+bool Registry::HasComponent(Entity entity, int componentId) const {
+	return GetEntitySignature(entity.GetId()).test(componentId);
+}
+
+void Registry::CopyComponent(Entity entity, int componentId, void* destination) const {
+	const ComponentInfo& info = IComponent::GetInfo(componentId);
+	if (storageMode == StorageMode::Archetypes) {
+		info.copyConstruct(destination, archetypeStorage.GetComponent(entity.GetId(), componentId));
+	}
+	else {
+		info.constructFromPool(*componentPools[componentId], entity.GetId(), destination);
+	}
+}
+
+IPool* Registry::GetOrCreatePool(int componentId) {
+	if (componentId >= componentPools.size()) {
+		componentPools.resize(componentId + 1);
+	}
+	if (!componentPools[componentId]) {
+		componentPools[componentId].reset(IComponent::GetInfo(componentId).createPool());
+	}
+	return UnsharePool(componentId);
+}
+
+void Registry::AddPrefabComponents(std::span<const Entity> entities, const Prefab& prefab, const Signature& overridden) {
+	if (storageMode == StorageMode::Archetypes) {
+		const Signature signature = prefab.signature | overridden;
+		for (Entity entity : entities) {
+			const int entityId = entity.GetId();
+			const Signature& previous = GetEntitySignature(entityId);
+			archetypeStorage.AddComponents(entityId, signature);
+			for (const Prefab::PrefabComponent& prefabComponent : prefab.components) {
+				if (overridden.test(prefabComponent.componentId)) {
+					continue;
+				}
+				const ComponentInfo& info = IComponent::GetInfo(prefabComponent.componentId);
+				void* component = archetypeStorage.GetComponent(entityId, prefabComponent.componentId);
+				if (previous.test(prefabComponent.componentId)) {
+					info.destroy(component);
+				}
+				info.copyConstruct(component, prefabComponent.component);
+			}
+		}
+		return;
+	}
+
+	// pool by pool, so each pool is looked up once for the whole batch
+	for (const Prefab::PrefabComponent& prefabComponent : prefab.components) {
+		if (!overridden.test(prefabComponent.componentId)) {
+			GetOrCreatePool(prefabComponent.componentId)->AddCopies(entities, prefabComponent.component, currentTick);
+		}
+	}
+}
+
+void Registry::FinishPrefabEntities(std::span<const Entity> entities, const Prefab& prefab, const Signature& overridden) {
+	const Signature signature = prefab.signature | overridden;
+	for (Entity entity : entities) {
+		const Signature& entitySignature = GetEntitySignature(entity.GetId());
+		for (int componentId = 0; componentId < componentObservers.size(); componentId++) {
+			if (signature.test(componentId)) {
+				QueueComponentEvent(componentId, entitySignature.test(componentId) ? ComponentEvent::Replaced : ComponentEvent::Added, entity);
+			}
+		}
+		if (!entitySignature.Contains(signature)) {
+			entitySignatures[entity.GetId()] = signatureTable.GetId(entitySignature | signature);
+			MarkEntityDirty(entity.GetId());
+		}
+	}
+
+	if (prefab.tagId >= 0) {
+		for (Entity entity : entities) {
+			TagEntity(entity, prefab.tagId);
+		}
+	}
+	if (prefab.groupId >= 0) {
+		for (Entity entity : entities) {
+			GroupEntity(entity, prefab.groupId);
+		}
+	}
+}
+
+const std::vector<System*>& Registry::GetMatchingSystems(int signatureId) {
+	if (signatureId >= systemsPerSignature.size()) {
+		systemsPerSignature.resize(signatureId + 1);
+	}
+	std::optional<std::vector<System*>>& cached = systemsPerSignature[signatureId];
+	if (cached) {
+		return *cached;
+	}
+
+	const Signature& signature = signatureTable.Get(signatureId);
+	std::vector<System*>& matchingSystems = cached.emplace();
+	for (auto& system : systems) {
+		if (signature.Contains(system.second->GetComponentSignature())) {
+			matchingSystems.push_back(system.second.get());
+		}
+	}
+	return matchingSystems;
+}
+
+void Registry::AddEntityToSystems(Entity entity) {
+	for (System* system : GetMatchingSystems(entitySignatures[entity.GetId()])) {
+		system->AddEntityToSystem(entity);
+	}
+}
+
+void Registry::UpdateSystemMembership() {
+	for (int entityId : dirtyEntities) {
+		EntityMembership& membership = entityMemberships[entityId];
+		membership.dirty = false;
+
+		const int signatureId = entitySignatures[entityId];
+		if (membership.inSystems && membership.signatureId == signatureId) {
+			continue;
+		}
+
+		Entity entity(entityId, entityGenerations[entityId]);
+		entity.registry = this;
+
+		// deque references stay valid when the cache grows
+		const std::vector<System*>& newSystems = GetMatchingSystems(signatureId);
+		if (membership.inSystems) {
+			const std::vector<System*>& oldSystems = GetMatchingSystems(membership.signatureId);
+			for (System* system : oldSystems) {
+				if (std::find(newSystems.begin(), newSystems.end(), system) == newSystems.end()) {
+					system->RemoveEntityFromSystem(entity);
+				}
+			}
+			for (System* system : newSystems) {
+				if (std::find(oldSystems.begin(), oldSystems.end(), system) == oldSystems.end()) {
+					system->AddEntityToSystem(entity);
+				}
+			}
+		}
+		else {
+			for (System* system : newSystems) {
+				system->AddEntityToSystem(entity);
+			}
+		}
+
+		membership.signatureId = signatureId;
+		membership.inSystems = true;
+	}
+	dirtyEntities.clear();
 }
 
 void Registry::RemoveEntityFromSystems(Entity entity) {
-	for (auto system : systems) {
+	for (auto& system : systems) {
 		system.second->RemoveEntityFromSystem(entity);
+	}
+}
 
-		entityComponentSignatures[entity.GetId()].reset();
+void Registry::RemoveEntitiesFromSystems(const std::vector<Entity>& entitiesToRemove) {
+	for (auto& system : systems) {
+		system.second->RemoveEntitiesFromSystem(entitiesToRemove);
+	}
+}
 
-		freeIds.push_back(entity.GetId());
+int Registry::GetTagId(const std::string& tag) {
+	// tags are unlimited, a tag names a single entity
+	return InternName(TagNames(), tag, std::numeric_limits<int>::max());
+}
+
+int Registry::GetGroupId(const std::string& group) {
+	const int groupId = InternName(GroupNames(), group, MAX_GROUPS);
+	if (groupId < 0) {
+		Logger::Err("Group " + group + " can't be used, all " + std::to_string(MAX_GROUPS) + " group ids are taken");
 	}
+	return groupId;
+}
+
+const std::string& Registry::GetTagName(int tagId) {
+	std::lock_guard<std::mutex> lock(TagNames().mutex);
+	return TagNames().names[tagId];
+}
+
+const std::string& Registry::GetGroupName(int groupId) {
+	std::lock_guard<std::mutex> lock(GroupNames().mutex);
+	return GroupNames().names[groupId];
 }
 
 void Registry::TagEntity(Entity entity, const std::string& tag) {
-	entityPerTag.emplace(tag, entity);
-	tagPerEntity.emplace(entity.GetId(), tag);
+	TagEntity(entity, GetTagId(tag));
 }
 
-bool Registry::EntityHasTag(Entity entity, const std::string& tag) const {
-	if (tagPerEntity.find(entity.GetId()) == tagPerEntity.end()) {
-		return false;
+void Registry::TagEntity(Entity entity, int tagId) {
+	if (tagId >= entityPerTag.size()) {
+		entityPerTag.resize(tagId + 1);
 	}
-	return entityPerTag.find(tag)->second == entity;
+	std::optional<Entity>& taggedEntity = entityPerTag[tagId];
+	if (taggedEntity) {
+		if (*taggedEntity != entity) {
+			Logger::Err("Tag " + GetTagName(tagId) + " already names entity " + std::to_string(taggedEntity->GetId()));
+		}
+		return;
+	}
+
+	// the entity gives up the tag it had before
+	RemoveEntityTag(entity);
+	taggedEntity = entity;
+	entityTags[entity.GetId()] = tagId;
+}
+
+bool Registry::EntityHasTag(Entity entity, const std::string& tag) const {
+	// a tag that was never interned can't name an entity
+	const int tagId = FindName(TagNames(), tag);
+	return tagId >= 0 && EntityHasTag(entity, tagId);
+}
+
+bool Registry::EntityHasTag(Entity entity, int tagId) const {
+	// a handle whose id was reused doesn't have the tag of the new entity
+	return tagId >= 0 && IsEntityAlive(entity) && entityTags[entity.GetId()] == tagId;
 }
 
 Entity Registry::GetEntityByTag(const std::string& tag) const {
-	return entityPerTag.at(tag);
+	const int tagId = FindName(TagNames(), tag);
+	if (tagId < 0 || tagId >= entityPerTag.size() || !entityPerTag[tagId]) {
+		Logger::Err("No entity has the tag " + tag);
+	}
+	return entityPerTag.at(tagId).value();
 }
 
 void Registry::RemoveEntityTag(Entity entity) {
-	auto taggedEntity = tagPerEntity.find(entity.GetId());
-	if (taggedEntity != tagPerEntity.end()) {
-		std::string tag = taggedEntity->second;
-		entityPerTag.erase(tag);
-		tagPerEntity.erase(taggedEntity);
+	int& tagId = entityTags[entity.GetId()];
+	if (tagId >= 0) {
+		entityPerTag[tagId].reset();
+		tagId = -1;
+	}
+}
+
+void Registry::GroupEntities(std::span<const Entity> entities, const std::string& group) {
+	const int groupId = GetGroupId(group);
+	if (groupId < 0) {
+		return;
+	}
+	entitiesPerGroup[groupId].entities.reserve(entitiesPerGroup[groupId].entities.size() + entities.size());
+	for (Entity entity : entities) {
+		GroupEntity(entity, groupId);
 	}
 }
 
 void Registry::GroupEntity(Entity entity, const std::string& group) {
-	entitiesPerGroup.emplace(group, std::set<Entity>());
-	entitiesPerGroup[group].emplace(entity);
-	groupPerEntity.emplace(entity.GetId(), group);
+	const int groupId = GetGroupId(group);
+	if (groupId >= 0) {
+		GroupEntity(entity, groupId);
+	}
+}
+
+void Registry::GroupEntity(Entity entity, int groupId) {
+	const int entityId = entity.GetId();
+	if (entityGroups[entityId].test(groupId)) {
+		return;
+	}
+	entityGroups[entityId].set(groupId);
+
+	GroupMembers& group = entitiesPerGroup[groupId];
+	if (entityId >= group.entityIndices.size()) {
+		group.entityIndices.resize(entityId + 1, -1);
+	}
+	group.entityIndices[entityId] = static_cast<int>(group.entities.size());
+	group.entities.push_back(entity);
 }
 
 bool Registry::EntityBelongsToGroup(Entity entity, const std::string& group) const {
+	// a group that was never interned has no members
+	const int groupId = FindName(GroupNames(), group);
+	return groupId >= 0 && EntityBelongsToGroup(entity, groupId);
+}
 
-	if (entitiesPerGroup.find(group) == entitiesPerGroup.end()) {
-		return false;
+bool Registry::EntityBelongsToGroup(Entity entity, int groupId) const {
+	return groupId >= 0 && IsEntityAlive(entity) && entityGroups[entity.GetId()].test(groupId);
+}
+
+std::span<const Entity> Registry::GetEntitiesByGroup(const std::string& group) const {
+	const int groupId = FindName(GroupNames(), group);
+	if (groupId < 0) {
+		return {};
 	}
+	return GetEntitiesByGroup(groupId);
+}
 
-	auto groupEntities = entitiesPerGroup.at(group);
-	return groupEntities.find(entity.GetId()) != groupEntities.end();
+std::span<const Entity> Registry::GetEntitiesByGroup(int groupId) const {
+	return entitiesPerGroup[groupId].entities;
 }
 
-std::vector<Entity> Registry::GetEntitiesByGroup(const std::string& group) const {
-	auto& setOfEntities = entitiesPerGroup.at(group);
-	return std::vector<Entity>(setOfEntities.begin(), setOfEntities.end());
+void Registry::RemoveEntityFromGroup(Entity entity, int groupId) {
+	const int entityId = entity.GetId();
+	if (!entityGroups[entityId].test(groupId)) {
+		return;
+	}
+	entityGroups[entityId].reset(groupId);
+
+	// the last member takes the place of the removed one
+	GroupMembers& group = entitiesPerGroup[groupId];
+	const int index = group.entityIndices[entityId];
+	const Entity lastEntity = group.entities.back();
+	group.entities[index] = lastEntity;
+	group.entityIndices[lastEntity.GetId()] = index;
+	group.entities.pop_back();
+	group.entityIndices[entityId] = -1;
 }
 
 void Registry::RemoveEntityGroup(Entity entity) {
-	auto groupedEntity = groupPerEntity.find(entity.GetId());
-	if (groupedEntity != groupPerEntity.end()) {
-		auto group = entitiesPerGroup.find(groupedEntity->second);
-		if (group != entitiesPerGroup.end()) {
-			auto entityInGroup = group->second.find(entity);
-			if (entityInGroup != group->second.end()) {
-				group->second.erase(entityInGroup);
-			}
+	const GroupMask groups = entityGroups[entity.GetId()];
+	for (int groupId = 0; groupId < MAX_GROUPS; groupId++) {
+		if (groups.test(groupId)) {
+			RemoveEntityFromGroup(entity, groupId);
 		}
-		groupPerEntity.erase(groupedEntity);
 	}
 }
 
 
-void Registry::Update() {
-	// add entities that are waiting to be created to the active Systems
-	for (Entity entity : entitiesToBeAdded) {
-		AddEntityToSystems(entity);
+RegistryStats Registry::GetStats() const {
+	RegistryStats stats;
+	stats.tick = currentTick;
+	stats.entityIdCount = numEntities;
+	stats.freeIdCount = static_cast<int>(freeIds.size());
+	stats.aliveEntityCount = numEntities - stats.freeIdCount;
+	stats.pendingAddCount = static_cast<int>(dirtyEntities.size());
+	stats.pendingKillCount = static_cast<int>(entitiesToBeKilled.size());
+	stats.signatureCount = signatureTable.GetCount();
+
+	stats.entityBytes = entitySignatures.capacity() * sizeof(int)
+		+ entityGenerations.capacity() * sizeof(std::uint32_t)
+		+ entityMemberships.capacity() * sizeof(EntityMembership)
+		+ dirtyEntities.capacity() * sizeof(int)
+		+ freeIds.size() * sizeof(int);
+
+	stats.tagAndGroupBytes = entityTags.capacity() * sizeof(int)
+		+ entityPerTag.capacity() * sizeof(std::optional<Entity>)
+		+ entityGroups.capacity() * sizeof(GroupMask);
+	for (const GroupMembers& group : entitiesPerGroup) {
+		stats.tagAndGroupBytes += group.entities.capacity() * sizeof(Entity) + group.entityIndices.capacity() * sizeof(int);
 	}
-	entitiesToBeAdded.clear();
 
-	for (Entity entity : entitiesToBeKilled) {
-		RemoveEntityFromSystems(entity);
-		entityComponentSignatures[entity.GetId()].reset();
+	for (const std::unique_ptr<CommandBuffer>& buffer : commandBuffers) {
+		stats.pendingCommandCount += static_cast<int>(buffer->commands.size());
+		stats.commandBufferBytes += buffer->commands.capacity() * sizeof(CommandBuffer::Command);
+		for (const CommandBuffer::Block& block : buffer->blocks) {
+			stats.commandBufferBytes += block.size;
+		}
+	}
+
+	for (int componentId = 0; componentId < componentPools.size(); componentId++) {
+		const std::shared_ptr<IPool>& pool = componentPools[componentId];
+		if (!pool) {
+			continue;
+		}
+		PoolStats poolStats;
+		poolStats.componentId = componentId;
+		poolStats.name = IComponent::GetInfo(componentId).name;
+		poolStats.count = pool->GetSize();
+		poolStats.capacity = pool->GetCapacity();
+		poolStats.bytes = pool->GetBytes();
+		poolStats.growthCount = pool->GetGrowthCount();
+		poolStats.fragmentation = poolStats.capacity > 0 ? 1.0f - static_cast<float>(poolStats.count) / poolStats.capacity : 0.0f;
+		poolStats.shared = pool.use_count() > 1;
+		stats.pools.push_back(poolStats);
+	}
+
+	for (const auto& system : systems) {
+		stats.systems.push_back({ system.first.name(), system.second->GetEntityCount(), system.second->GetEntityBytes() });
+	}
+	// the systems map has no stable order, sort so dumps of consecutive frames line up
+	std::sort(stats.systems.begin(), stats.systems.end(), [](const SystemStats& a, const SystemStats& b) { return a.name < b.name; });
+
+	int rowCapacity = 0;
+	int rowCount = 0;
+	for (const std::unique_ptr<Archetype>& archetype : archetypeStorage.GetArchetypes()) {
+		stats.archetypeCount++;
+		stats.chunkCount += archetype->GetChunkCount();
+		stats.chunkBytes += archetype->GetChunkCount() * archetype->GetChunkBytes();
+		rowCapacity += archetype->GetChunkCount() * archetype->GetChunkCapacity();
+		rowCount += archetype->GetEntityCount();
+	}
+	stats.chunkFragmentation = rowCapacity > 0 ? 1.0f - static_cast<float>(rowCount) / rowCapacity : 0.0f;
+
+	return stats;
+}
+
+size_t RegistryStats::GetTotalBytes() const {
+	size_t bytes = entityBytes + tagAndGroupBytes + commandBufferBytes + chunkBytes;
+	for (const PoolStats& pool : pools) {
+		bytes += pool.bytes;
+	}
+	for (const SystemStats& system : systems) {
+		bytes += system.bytes;
+	}
+	return bytes;
+}
+
+void RegistryStats::Write(std::ostream& stream) const {
+	stream << tick << "\tregistry\t" << aliveEntityCount << '\t' << entityIdCount << '\t' << freeIdCount << '\t'
+		<< pendingAddCount << '\t' << pendingKillCount << '\t' << pendingCommandCount << '\t'
+		<< signatureCount << '\t' << GetTotalBytes() << '\n';
+	for (const PoolStats& pool : pools) {
+		stream << tick << "\tpool\t" << pool.name << '\t' << pool.count << '\t' << pool.capacity << '\t'
+			<< pool.bytes << '\t' << pool.growthCount << '\t' << pool.fragmentation << '\t' << pool.shared << '\n';
+	}
+	for (const SystemStats& system : systems) {
+		stream << tick << "\tsystem\t" << system.name << '\t' << system.entityCount << '\t' << system.bytes << '\n';
+	}
+	if (archetypeCount > 0) {
+		stream << tick << "\tarchetypes\t" << archetypeCount << '\t' << chunkCount << '\t' << chunkBytes << '\t' << chunkFragmentation << '\n';
+	}
+}
+
+void Registry::Update() {
+	currentTick++;
+
+	// structural changes recorded by systems, entities they create join systems below
+	ApplyCommandBuffers();
+
+	// created entities join systems, changed entities only move between the systems they gained or lost
+	UpdateSystemMembership();
+
+	// every system drops all the killed entities in a single pass
+	killedEntities.assign(entitiesToBeKilled.begin(), entitiesToBeKilled.end());
+	entitiesToBeKilled.clear();
+	RemoveEntitiesFromSystems(killedEntities);
 
-		for (auto pool : componentPools) {
-			if (pool)
-				pool->RemoveEntityFromPool(entity.GetId());
+	for (Entity entity : killedEntities) {
+		// observers hear about every component the killed entity had
+		const Signature& signature = GetEntitySignature(entity.GetId());
+		for (int componentId = 0; componentId < componentObservers.size(); componentId++) {
+			if (signature.test(componentId)) {
+				QueueComponentEvent(componentId, ComponentEvent::Removed, entity);
+			}
 		}
 
+		entitySignatures[entity.GetId()] = SignatureTable::EMPTY;
+		entityMemberships[entity.GetId()] = EntityMembership();
+
+		if (storageMode == StorageMode::Archetypes) {
+			archetypeStorage.RemoveEntity(entity.GetId());
+		}
+		else {
+			for (int componentId = 0; componentId < componentPools.size(); componentId++) {
+				const std::shared_ptr<IPool>& pool = componentPools[componentId];
+				if (pool && pool->Contains(entity.GetId()))
+					UnsharePool(componentId)->RemoveEntityFromPool(entity.GetId());
+			}
+		}
+
+		// invalidate outstanding handles before the id can be reused
+		entityGenerations[entity.GetId()]++;
 		freeIds.push_back(entity.GetId());
 
 		RemoveEntityTag(entity);
 		RemoveEntityGroup(entity);
 	}
-	entitiesToBeKilled.clear();
-}
\ No newline at end of file
+	killedEntities.clear();
+
+	DispatchComponentEvents();
+}
+
+void Registry::AddObserver(int componentId, ComponentEvent event, ComponentObserver observer) {
+	if (componentId >= componentObservers.size()) {
+		componentObservers.resize(componentId + 1);
+	}
+	componentObservers[componentId].observers[static_cast<int>(event)].push_back(std::move(observer));
+}
+
+void Registry::DispatchComponentEvents() {
+	for (int componentId = 0; componentId < componentObservers.size(); componentId++) {
+		for (int eventIndex = 0; eventIndex < 3; eventIndex++) {
+			std::vector<Entity>& pendingEntities = componentObservers[componentId].pendingEntities[eventIndex];
+			if (pendingEntities.empty()) {
+				continue;
+			}
+
+			// events queued by the observers themselves are dispatched in the next Update()
+			dispatchedEntities.swap(pendingEntities);
+			for (const ComponentObserver& observer : componentObservers[componentId].observers[eventIndex]) {
+				observer(std::span<const Entity>(dispatchedEntities));
+			}
+			dispatchedEntities.clear();
+		}
+	}
+}
+
+std::vector<std::byte> Registry::SaveSnapshot() const {
+	// components plus their entity ids, the rest is small next to it
+	size_t expectedSize = 4096 + numEntities * sizeof(std::uint32_t);
+	for (int componentId = 0; componentId < componentPools.size(); componentId++) {
+		if (componentPools[componentId]) {
+			expectedSize += componentPools[componentId]->GetSize() * (sizeof(int) + IComponent::GetInfo(componentId).size + SnapshotWriter::ALIGNMENT);
+		}
+	}
+	SnapshotWriter writer(expectedSize);
+
+	// the header is written again once the counts and offsets are known
+	SnapshotHeader header;
+	header.entityCount = numEntities;
+	writer.Write(header);
+
+	writer.WriteArray(entityGenerations.data(), numEntities);
+
+	const std::vector<std::int32_t> freeIdList(freeIds.begin(), freeIds.end());
+	header.freeIdCount = static_cast<std::uint32_t>(freeIdList.size());
+	writer.WriteArray(freeIdList.data(), freeIdList.size());
+
+	std::vector<SnapshotEntityString> tags;
+	for (int tagId = 0; tagId < entityPerTag.size(); tagId++) {
+		if (entityPerTag[tagId] && IsEntityAlive(*entityPerTag[tagId])) {
+			tags.push_back({ entityPerTag[tagId]->GetId(), writer.InternString(GetTagName(tagId)) });
+		}
+	}
+	header.tagCount = static_cast<std::uint32_t>(tags.size());
+	writer.WriteArray(tags.data(), tags.size());
+
+	std::vector<SnapshotEntityString> groups;
+	for (int groupId = 0; groupId < MAX_GROUPS; groupId++) {
+		const std::vector<Entity>& groupEntities = entitiesPerGroup[groupId].entities;
+		if (groupEntities.empty()) {
+			continue;
+		}
+		const std::uint32_t groupString = writer.InternString(GetGroupName(groupId));
+		for (Entity entity : groupEntities) {
+			if (IsEntityAlive(entity)) {
+				groups.push_back({ entity.GetId(), groupString });
+			}
+		}
+	}
+	header.groupCount = static_cast<std::uint32_t>(groups.size());
+	writer.WriteArray(groups.data(), groups.size());
+
+	const int componentCount = IComponent::GetCount();
+	for (int componentId = 0; componentId < componentCount; componentId++) {
+		const ComponentInfo& info = IComponent::GetInfo(componentId);
+
+		const IPool* pool = nullptr;
+		std::unique_ptr<IPool> archetypeComponents;
+		if (storageMode == StorageMode::Archetypes) {
+			// gather the components spread over the archetypes into a pool, so the record has the same layout
+			archetypeComponents.reset(info.createPool());
+			for (const auto& archetype : archetypeStorage.GetArchetypes()) {
+				if (!archetype->GetSignature().test(componentId)) {
+					continue;
+				}
+				for (int row = 0; row < archetype->GetEntityCount(); row++) {
+					info.copyToPool(*archetypeComponents, Entity(archetype->GetHandle(row)).GetId(), archetype->GetComponent(row, componentId));
+				}
+			}
+			pool = archetypeComponents.get();
+		}
+		else if (componentId < componentPools.size()) {
+			pool = componentPools[componentId].get();
+		}
+
+		if (!pool || pool->IsEmpty()) {
+			continue;
+		}
+		if (!info.serializable) {
+			Logger::Err(std::string("Component ") + info.name + " is not saved in the snapshot, it is not a plain value, isn't reflected and has no Save() and Load()");
+			continue;
+		}
+		SavePool(writer, componentId, *pool);
+		header.poolCount++;
+	}
+
+	writer.Align();
+	header.stringTableOffset = writer.GetOffset();
+	writer.Write(static_cast<std::uint32_t>(writer.GetStrings().size()));
+	for (const std::string* string : writer.GetStrings()) {
+		writer.Write(static_cast<std::uint32_t>(string->size()));
+		writer.WriteBytes(string->data(), string->size());
+	}
+
+	header.size = writer.GetOffset();
+	std::memcpy(writer.GetData(), &header, sizeof(header));
+
+	Logger::Log("Snapshot saved with " + std::to_string(numEntities) + " entity ids and " + std::to_string(header.poolCount) + " pools");
+
+	return writer.Release();
+}
+
+void Registry::SavePool(SnapshotWriter& writer, int componentId, const IPool& pool) const {
+	const ComponentInfo& info = IComponent::GetInfo(componentId);
+
+	writer.Align();
+	const size_t headerOffset = writer.GetOffset();
+	SnapshotPoolHeader poolHeader;
+	poolHeader.name = writer.InternString(info.name);
+	poolHeader.componentSize = static_cast<std::uint32_t>(info.size);
+	poolHeader.count = static_cast<std::uint32_t>(pool.GetSize());
+	writer.Write(poolHeader);
+
+	writer.WriteArray(pool.GetEntityIds().data(), pool.GetSize());
+	pool.Save(writer);
+
+	// the end offset is only known now
+	poolHeader.end = writer.GetOffset();
+	std::memcpy(writer.GetData() + headerOffset, &poolHeader, sizeof(poolHeader));
+}
+
+bool Registry::CheckSnapshotPools(SnapshotReader& reader, const SnapshotHeader& header, const std::vector<bool>& aliveEntities) const {
+	// pool number that last listed each entity id, an id listed twice by one pool is damage
+	std::vector<std::uint32_t> listedByPool(header.entityCount, 0);
+	std::vector<std::int32_t> entityIds;
+
+	for (std::uint32_t pool = 1; pool <= header.poolCount; pool++) {
+		reader.Align();
+		const SnapshotPoolHeader poolHeader = reader.Read<SnapshotPoolHeader>();
+		reader.GetString(poolHeader.name);
+		if (!reader.IsValid() || poolHeader.count > header.entityCount) {
+			return false;
+		}
+
+		entityIds.resize(poolHeader.count);
+		reader.ReadArray(entityIds.data(), entityIds.size());
+		if (!reader.IsValid() || poolHeader.end < reader.GetOffset() || poolHeader.end > header.stringTableOffset) {
+			return false;
+		}
+
+		for (std::int32_t entityId : entityIds) {
+			if (entityId < 0 || entityId >= static_cast<std::int32_t>(header.entityCount) || !aliveEntities[entityId] || listedByPool[entityId] == pool) {
+				return false;
+			}
+			listedByPool[entityId] = pool;
+		}
+		reader.Seek(poolHeader.end);
+	}
+	return reader.IsValid();
+}
+
+bool Registry::LoadSnapshot(std::span<const std::byte> snapshot) {
+	SnapshotReader reader(snapshot);
+	const SnapshotHeader header = reader.Read<SnapshotHeader>();
+	if (!reader.IsValid() || header.magic != SnapshotHeader::MAGIC || header.version != SnapshotHeader::VERSION || header.size != snapshot.size()) {
+		Logger::Err("Snapshot is not a registry snapshot of version " + std::to_string(SnapshotHeader::VERSION));
+		return false;
+	}
+	reader.ReadStringTable(header.stringTableOffset);
+
+	std::vector<std::uint32_t> generations(header.entityCount);
+	reader.ReadArray(generations.data(), generations.size());
+	std::vector<std::int32_t> loadedFreeIds(header.freeIdCount);
+	reader.ReadArray(loadedFreeIds.data(), loadedFreeIds.size());
+	std::vector<SnapshotEntityString> tags(header.tagCount);
+	reader.ReadArray(tags.data(), tags.size());
+	std::vector<SnapshotEntityString> groups(header.groupCount);
+	reader.ReadArray(groups.data(), groups.size());
+
+	// check everything the snapshot refers to before the current world is dropped
+	std::vector<bool> aliveEntities(header.entityCount, true);
+	bool valid = reader.IsValid();
+	for (std::int32_t entityId : loadedFreeIds) {
+		if (entityId < 0 || entityId >= static_cast<std::int32_t>(header.entityCount)) {
+			valid = false;
+			break;
+		}
+		aliveEntities[entityId] = false;
+	}
+	auto isAlive = [&](const SnapshotEntityString& entry) {
+		return entry.entityId >= 0 && entry.entityId < static_cast<std::int32_t>(header.entityCount) && aliveEntities[entry.entityId];
+	};
+	valid = valid && std::all_of(tags.begin(), tags.end(), isAlive) && std::all_of(groups.begin(), groups.end(), isAlive);
+
+	const size_t poolsOffset = reader.GetOffset();
+	if (!valid || !CheckSnapshotPools(reader, header, aliveEntities)) {
+		Logger::Err("Snapshot is damaged, the registry was not changed");
+		return false;
+	}
+
+	Clear();
+
+	numEntities = static_cast<int>(header.entityCount);
+	entityGenerations = std::move(generations);
+	entitySignatures.assign(numEntities, SignatureTable::EMPTY);
+	entityMemberships.assign(numEntities, EntityMembership());
+	entityTags.assign(numEntities, -1);
+	entityGroups.assign(numEntities, GroupMask());
+	freeIds.assign(loadedFreeIds.begin(), loadedFreeIds.end());
+
+	auto loadedEntity = [this](int entityId) {
+		Entity entity(entityId, entityGenerations[entityId]);
+		entity.registry = this;
+		return entity;
+	};
+
+	dirtyEntities.reserve(numEntities);
+	for (int entityId = 0; entityId < numEntities; entityId++) {
+		if (!aliveEntities[entityId]) {
+			continue;
+		}
+		if (storageMode == StorageMode::Archetypes) {
+			archetypeStorage.AddEntity(loadedEntity(entityId));
+		}
+		MarkEntityDirty(entityId);
+	}
+
+	for (const SnapshotEntityString& tag : tags) {
+		TagEntity(loadedEntity(tag.entityId), reader.GetString(tag.string));
+	}
+	for (const SnapshotEntityString& group : groups) {
+		GroupEntity(loadedEntity(group.entityId), reader.GetString(group.string));
+	}
+
+	reader.Seek(poolsOffset);
+	std::vector<std::int32_t> entityIds;
+	for (std::uint32_t pool = 0; pool < header.poolCount; pool++) {
+		reader.Align();
+		const SnapshotPoolHeader poolHeader = reader.Read<SnapshotPoolHeader>();
+		entityIds.resize(poolHeader.count);
+		reader.ReadArray(entityIds.data(), entityIds.size());
+
+		const std::string& name = reader.GetString(poolHeader.name);
+		const int componentId = IComponent::FindId(name);
+		if (componentId < 0 || !IComponent::GetInfo(componentId).serializable || IComponent::GetInfo(componentId).size != poolHeader.componentSize) {
+			Logger::Err("Snapshot pool of component " + name + " is skipped, the type is unknown or has changed");
+			reader.Seek(poolHeader.end);
+			continue;
+		}
+		const ComponentInfo& info = IComponent::GetInfo(componentId);
+
+		if (storageMode == StorageMode::Archetypes) {
+			std::unique_ptr<IPool> loadedComponents(info.createPool());
+			loadedComponents->Load(reader, entityIds, currentTick);
+			for (std::int32_t entityId : entityIds) {
+				info.constructFromPool(*loadedComponents, entityId, archetypeStorage.AddComponent(entityId, componentId));
+			}
+		}
+		else {
+			if (componentId >= componentPools.size()) {
+				componentPools.resize(componentId + 1);
+			}
+			if (!componentPools[componentId]) {
+				componentPools[componentId].reset(info.createPool());
+			}
+			componentPools[componentId]->Load(reader, entityIds, currentTick);
+		}
+
+		// components that write themselves can still run past their record
+		if (!reader.IsValid() || reader.GetOffset() > poolHeader.end) {
+			Clear();
+			Logger::Err("Snapshot pool of component " + name + " is damaged, the registry was cleared");
+			return false;
+		}
+		reader.Seek(poolHeader.end);
+
+		for (std::int32_t entityId : entityIds) {
+			entitySignatures[entityId] = signatureTable.With(entitySignatures[entityId], componentId);
+			QueueComponentEvent(componentId, ComponentEvent::Added, loadedEntity(entityId));
+		}
+	}
+
+	Logger::Log("Snapshot loaded with " + std::to_string(numEntities) + " entity ids and " + std::to_string(header.poolCount) + " pools");
+	return true;
+}
+
+bool Registry::SaveSnapshotToFile(const std::string& filePath) const {
+	const std::vector<std::byte> snapshot = SaveSnapshot();
+	std::ofstream file(filePath, std::ios::binary);
+	if (!file.write(reinterpret_cast<const char*>(snapshot.data()), snapshot.size())) {
+		Logger::Err("Could not write snapshot file " + filePath);
+		return false;
+	}
+	return true;
+}
+
+bool Registry::LoadSnapshotFromFile(const std::string& filePath) {
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file) {
+		Logger::Err("Could not open snapshot file " + filePath);
+		return false;
+	}
+	std::vector<std::byte> snapshot(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	if (!file.read(reinterpret_cast<char*>(snapshot.data()), snapshot.size())) {
+		Logger::Err("Could not read snapshot file " + filePath);
+		return false;
+	}
+	return LoadSnapshot(snapshot);
+}
@@ -1,55 +1,139 @@
 #pragma once
 #include <bitset>
+#include <cstdint>
 #include <vector>
 #include <unordered_map>
 #include <typeindex>
 #include <set>
 #include <memory>
 #include <deque>
+#include <functional>
+#include <iterator>
+#include <array>
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <typeinfo>
+#include <type_traits>
+#include "Reflection.hpp"
+#include "RegistryStats.hpp"
+#include "Signature.hpp"
+#include "Snapshot.hpp"
 #include "../Logger/Logger.hpp"
 
 
-const unsigned int MAX_COMPONENTS = 32;
+const unsigned int MAX_GROUPS = 32;
 
 /*
- a bitset (1s and 0s) to keep track of which components an enity has,
- and also helps keep track of which entities a given sytem is interested in.
+ a bitset with one bit per group id, keeps track of the groups an entity belongs to
 */
-typedef std::bitset<MAX_COMPONENTS> Signature;
+typedef std::bitset<MAX_GROUPS> GroupMask;
+
+/*
+ An entity handle packs the entity index in the low 32 bits and the generation
+ of that index in the high 32 bits. The generation is bumped every time the index
+ is freed, so handles to killed entities never alias a new entity
+*/
+typedef std::uint64_t EntityHandle;
+
+template <typename T> class Pool;
+
+// what GetMutableComponent<T>() returns, T& unless the pool of T stores the fields in separate arrays
+template <typename T>
+using ComponentReference = typename Pool<T>::Reference;
+// what GetComponent<T>() returns, const T& or a copy of the component when the pool stores separate arrays
+template <typename T>
+using ConstComponentReference = typename Pool<T>::ConstReference;
 
 class Entity {
 public:
-	Entity(int id) : id(id) {};
+	explicit Entity(EntityHandle handle) : handle(handle) {};
+	Entity(int id, std::uint32_t generation) : handle(MakeHandle(id, generation)) {};
 	Entity(const Entity& entity) = default;
 	void Kill();
+	bool IsAlive() const;
 	int GetId() const;
+	std::uint32_t GetGeneration() const;
+	EntityHandle GetHandle() const;
+
+	static EntityHandle MakeHandle(int id, std::uint32_t generation) {
+		return (static_cast<EntityHandle>(generation) << 32) | static_cast<std::uint32_t>(id);
+	}
 
 	void Tag(const std::string& tag);
 	bool HasTag(const std::string& tag) const;
+	// check by the id from Registry::GetTagId(), no string lookup
+	bool HasTag(int tagId) const;
 	void Group(const std::string& group);
 	bool BelongsToGroup(const std::string& group) const;
+	// check by the id from Registry::GetGroupId(), no string lookup
+	bool BelongsToGroup(int groupId) const;
 
 	// operator overloads
 	Entity& operator = (const Entity& other) = default;
-	bool operator == (const Entity& other) const { return id == other.id; }
-	bool operator != (const Entity& other) const { return id != other.id; }
-	bool operator > (const Entity& other) const { return id > other.id; }
-	bool operator < (const Entity& other) const { return id < other.id; }
+	bool operator == (const Entity& other) const { return handle == other.handle; }
+	bool operator != (const Entity& other) const { return handle != other.handle; }
+	bool operator > (const Entity& other) const { return other < *this; }
+	bool operator < (const Entity& other) const {
+		return GetId() < other.GetId() || (GetId() == other.GetId() && GetGeneration() < other.GetGeneration());
+	}
 
 	template <typename TComponent, typename ...TArgs> void AddComponent(TArgs&& ...args);
 	template <typename TComponent> void RemoveComponent();
 	template <typename TComponent> bool HasComponent() const;
-	template <typename TComponent> TComponent& GetComponent() const;
+	template <typename TComponent> ConstComponentReference<TComponent> GetComponent() const;
+	// write access that marks the component as changed, see Registry::GetMutableComponent()
+	template <typename TComponent> ComponentReference<TComponent> GetMutableComponent() const;
 
 	class Registry* registry = nullptr;
 
 private:
-	int id;
+	EntityHandle handle;
+};
+
+/*
+ ComponentInfo
+ Type erased description of a component type, used by storage that moves
+ components around without knowing their type
+*/
+struct ComponentInfo {
+	size_t size = 0;
+	size_t alignment = 0;
+	void (*moveConstruct)(void* destination, void* source) = nullptr;
+	void (*destroy)(void* component) = nullptr;
+	// creates an empty Pool<T> for the component type
+	class IPool* (*createPool)() = nullptr;
+	// REFLECT_COMPONENT name or the compiler's type name, identifies the component type in snapshots
+	const char* name = nullptr;
+	// false for components that can't be written to a snapshot, see Snapshot.hpp
+	bool serializable = false;
+	// copy a component into a Pool<T>, and construct a copy of a pooled component in uninitialized memory
+	void (*copyToPool)(class IPool& pool, int entityId, const void* component) = nullptr;
+	void (*constructFromPool)(const class IPool& pool, int entityId, void* destination) = nullptr;
+	// copy a component into uninitialized memory, nullptr for types that can't be copied
+	void (*copyConstruct)(void* destination, const void* source) = nullptr;
+	// components that can be copied with memcpy
+	bool triviallyCopyable = false;
+	// fields in declaration order, empty for components that aren't reflected, see Reflection.hpp
+	std::span<const FieldInfo> fields;
 };
 
 struct IComponent {
+public:
+	// returns the type information registered for a component id
+	static const ComponentInfo& GetInfo(int componentId);
+	// number of component types used so far
+	static int GetCount();
+	// id of the component type with the given ComponentInfo::name, -1 if the type hasn't been used yet
+	static int FindId(const std::string& name);
+
 protected:
 	static int nextId;
+	static int Register(const ComponentInfo& info);
 };
 
 // assign a unique id to a component type
@@ -58,139 +142,717 @@ class Component : public IComponent{
 public:
 	// returns unique id of Component<T>
 	static int GetId() {
-		static int id = nextId++;
+		static int id = Register(ComponentInfo{ sizeof(T), alignof(T), &MoveConstruct, &Destroy, &CreatePool, GetName(), IsSnapshotSerializable<T>, &CopyToPool, &ConstructFromPool, GetCopyConstruct(), std::is_trivially_copyable_v<T>, GetFields() });
 		return id;
 	}
+
+private:
+	static void MoveConstruct(void* destination, void* source) {
+		new (destination) T(std::move(*static_cast<T*>(source)));
+	}
+
+	static void Destroy(void* component) {
+		static_cast<T*>(component)->~T();
+	}
+
+	static void CopyConstruct(void* destination, const void* source) {
+		new (destination) T(*static_cast<const T*>(source));
+	}
+
+	static const char* GetName() {
+		if constexpr (ReflectedComponent<T>) {
+			return ComponentMetadata<T>::NAME;
+		}
+		else {
+			return typeid(T).name();
+		}
+	}
+
+	static std::span<const FieldInfo> GetFields() {
+		if constexpr (ReflectedComponent<T>) {
+			return ComponentMetadata<T>::GetFields();
+		}
+		else {
+			return {};
+		}
+	}
+
+	static auto GetCopyConstruct() -> void (*)(void*, const void*) {
+		if constexpr (std::is_copy_constructible_v<T>) {
+			return &CopyConstruct;
+		}
+		else {
+			return nullptr;
+		}
+	}
+
+	static class IPool* CreatePool();
+	static void CopyToPool(class IPool& pool, int entityId, const void* component);
+	static void ConstructFromPool(const class IPool& pool, int entityId, void* destination);
 };
 
 /*
- System
- The system processes entities that contain a specific signature
+ SparseSet
+ Maps entity ids to packed indices. The sparse array is indexed by entity id and
+ split into fixed size pages that are only allocated when an id in their range is
+ used, the dense array holds the entity id stored at each packed index
 */
-class System {
+class SparseSet {
 public:
-	System() = default;
-	~System() = default;
+	static constexpr int INVALID_INDEX = -1;
 
-	void AddEntityToSystem(Entity entity);
-	void RemoveEntityFromSystem(Entity entity);
-	std::vector<Entity> GetSystemEntities() const;
-	const Signature& GetComponentSignature() const;
+	SparseSet() = default;
+	virtual ~SparseSet() = default;
+
+	bool Contains(int entityId) const {
+		const size_t page = static_cast<size_t>(entityId) / SPARSE_PAGE_SIZE;
+		return page < sparse.size() && !sparse[page].empty() && sparse[page][entityId % SPARSE_PAGE_SIZE] != INVALID_INDEX;
+	}
+
+	// returns the packed index of an entity, the entity must be in the set
+	int IndexOf(int entityId) const {
+		return sparse[entityId / SPARSE_PAGE_SIZE][entityId % SPARSE_PAGE_SIZE];
+	}
+
+	int GetSize() const {
+		return static_cast<int>(dense.size());
+	}
 
-	// define component type entity must have to be considered by system
-	template <typename TComponent> void RequireComponent();
+	bool IsEmpty() const {
+		return dense.empty();
+	}
+
+	// entity ids in packed order
+	const std::vector<int>& GetEntityIds() const {
+		return dense;
+	}
+
+	// bumped whenever an entity id is added, removed or moved to another packed index
+	std::uint32_t GetLayoutVersion() const {
+		return layoutVersion;
+	}
+
+	// bytes reserved by the sparse pages and the packed array
+	size_t GetSetBytes() const {
+		size_t bytes = sparse.capacity() * sizeof(std::vector<int>) + dense.capacity() * sizeof(int);
+		for (const std::vector<int>& page : sparse) {
+			bytes += page.capacity() * sizeof(int);
+		}
+		return bytes;
+	}
+
+protected:
+	// add an entity id to the end of the packed array and return its index
+	int Insert(int entityId) {
+		const int index = static_cast<int>(dense.size());
+		SparseSlot(entityId) = index;
+		dense.push_back(entityId);
+		layoutVersion++;
+		return index;
+	}
+
+	/*
+	 Remove an entity id by moving the last id into its slot
+	 @return packed index the entity occupied
+	*/
+	int Erase(int entityId) {
+		const int index = IndexOf(entityId);
+		const int lastEntityId = dense.back();
+		dense[index] = lastEntityId;
+		sparse[lastEntityId / SPARSE_PAGE_SIZE][lastEntityId % SPARSE_PAGE_SIZE] = index;
+		sparse[entityId / SPARSE_PAGE_SIZE][entityId % SPARSE_PAGE_SIZE] = INVALID_INDEX;
+		dense.pop_back();
+		layoutVersion++;
+		return index;
+	}
+
+	// swap the entity ids stored at two packed indices
+	void SwapEntries(int a, int b) {
+		std::swap(dense[a], dense[b]);
+		sparse[dense[a] / SPARSE_PAGE_SIZE][dense[a] % SPARSE_PAGE_SIZE] = a;
+		sparse[dense[b] / SPARSE_PAGE_SIZE][dense[b] % SPARSE_PAGE_SIZE] = b;
+		layoutVersion++;
+	}
+
+	void ReserveSet(int capacity) {
+		dense.reserve(capacity);
+	}
+
+	void ClearSet() {
+		sparse.clear();
+		dense.clear();
+		layoutVersion++;
+	}
 
 private:
-	Signature componentSignature;
-	std::vector<Entity> entities;
+	static constexpr int SPARSE_PAGE_SIZE = 4096;
+
+	int& SparseSlot(int entityId) {
+		const size_t page = static_cast<size_t>(entityId) / SPARSE_PAGE_SIZE;
+		if (page >= sparse.size())
+			sparse.resize(page + 1);
+		if (sparse[page].empty())
+			sparse[page].assign(SPARSE_PAGE_SIZE, INVALID_INDEX);
+		return sparse[page][entityId % SPARSE_PAGE_SIZE];
+	}
+
+	// paged sparse array, entity id -> packed index
+	std::vector<std::vector<int>> sparse;
+	// packed array, index -> entity id
+	std::vector<int> dense;
+	std::uint32_t layoutVersion = 0;
 };
 
 /*
  IPool
  The IPool class is a parent class to pool (wrapper)
 */
-class IPool {
+class IPool : public SparseSet {
 public:
 	virtual ~IPool() = default;
 	virtual void RemoveEntityFromPool(int entityId) = 0;
+	virtual void Clear() = 0;
+	// copy of the pool, nullptr if the component type can't be copied
+	virtual IPool* Clone() const = 0;
+	// add a copy of the component to every entity, component points to a component of the pool's type
+	virtual void AddCopies(std::span<const Entity> entities, const void* component, std::uint32_t tick) = 0;
+
+	// write the components in packed order, the entity ids are written by the registry
+	virtual void Save(SnapshotWriter& writer) const = 0;
+	// replace the pool with one component per entity id read from the snapshot, stamped with tick
+	virtual void Load(SnapshotReader& reader, std::span<const int> entityIds, std::uint32_t tick) = 0;
+
+	// registry tick at which the component of the entity was added
+	std::uint32_t GetAddedTick(int entityId) const { return addedTicks[IndexOf(entityId)]; }
+	// registry tick of the last tracked write, adding a component counts as a write
+	std::uint32_t GetChangedTick(int entityId) const { return changedTicks[IndexOf(entityId)]; }
+	void MarkChanged(int entityId, std::uint32_t tick) { changedTicks[IndexOf(entityId)] = tick; }
+	// changed ticks in packed order, for loops that write whole ranges of the pool
+	std::uint32_t* GetChangedTicks() { return changedTicks.data(); }
+	const std::uint32_t* GetChangedTicks() const { return changedTicks.data(); }
+
+	// number of components the pool holds before its storage has to grow
+	virtual int GetCapacity() const = 0;
+	// bytes reserved for the components, not counting memory the components own
+	virtual size_t GetComponentBytes() const = 0;
+	// bytes reserved by the components, the sparse set and the ticks
+	size_t GetBytes() const {
+		return GetComponentBytes() + GetSetBytes() + (addedTicks.capacity() + changedTicks.capacity()) * sizeof(std::uint32_t);
+	}
+	// number of times adding a component had to grow the component storage
+	int GetGrowthCount() const { return growthCount; }
+
+	/*
+	 Reorder the pool so the entities it shares with the other set come first, in the
+	 packed order of the other set. Sorting two pools against each other lines up their
+	 shared entities at the same packed indices
+	 @return number of shared entities
+	*/
+	int SortAs(const SparseSet& other) {
+		int sharedCount = 0;
+		for (int entityId : other.GetEntityIds()) {
+			if (!Contains(entityId)) {
+				continue;
+			}
+			const int index = IndexOf(entityId);
+			if (index != sharedCount) {
+				SwapSlots(index, sharedCount);
+			}
+			sharedCount++;
+		}
+		return sharedCount;
+	}
+
+protected:
+	// swap everything stored at two packed indices, including the entity ids
+	virtual void SwapSlots(int a, int b) = 0;
+
+	// empty the set and ticks, then add the entity ids in order
+	void LoadEntityIds(std::span<const int> entityIds, std::uint32_t tick) {
+		ClearSet();
+		ReserveSet(static_cast<int>(entityIds.size()));
+		for (int entityId : entityIds) {
+			Insert(entityId);
+		}
+		addedTicks.assign(entityIds.size(), tick);
+		changedTicks.assign(entityIds.size(), tick);
+	}
+
+	// per slot ticks, kept in the same packed order as the entity ids
+	std::vector<std::uint32_t> addedTicks;
+	std::vector<std::uint32_t> changedTicks;
+	int growthCount = 0;
 };
 
 /*
  Pool
- A pool is just a vector of objects of type T
+ A pool is a packed vector of objects of type T, kept in the same order
+ as the entity ids of the sparse set. Component types can specialize Pool to
+ store their fields in separate arrays instead, see SoAPool.hpp
 */
 template <typename T>
 class Pool : public IPool{
 public:
+	// what Get() returns for write and read access
+	using Reference = T&;
+	using ConstReference = const T&;
+	// false for pools that don't hold T objects, their components have no address
+	static constexpr bool STORES_OBJECTS = true;
+
 	Pool(int capacity = 100) {
-		size = 0;
-		data.resize(capacity);
+		Reserve(capacity);
 	}
 
+	Pool(const Pool& other) = default;
 	virtual ~Pool() = default;
 
-	bool IsEmpty() const {
-		return size == 0;
+	void Reserve(int capacity) {
+		data.reserve(capacity);
+		addedTicks.reserve(capacity);
+		changedTicks.reserve(capacity);
+		ReserveSet(capacity);
 	}
 
-	int GetSize() const {
-		return size;
+	void Clear() override {
+		data.clear();
+		addedTicks.clear();
+		changedTicks.clear();
+		ClearSet();
 	}
 
-	void Resize(int capacity) {
-		data.resize(capacity);
+	IPool* Clone() const override {
+		if constexpr (std::is_copy_constructible_v<T>) {
+			return new Pool<T>(*this);
+		}
+		else {
+			return nullptr;
+		}
 	}
 
-	void Clear() {
-		data.clear();
-		size = 0;
+	void AddCopies(std::span<const Entity> entities, const void* component, std::uint32_t tick) override {
+		if constexpr (std::is_copy_constructible_v<T>) {
+			const T& object = *static_cast<const T*>(component);
+			for (Entity entity : entities) {
+				Set(entity.GetId(), object, tick);
+			}
+		}
 	}
 
-	void Add(T object) {
-		data.push_back(object);
+	void Save(SnapshotWriter& writer) const override {
+		if constexpr (SelfSerializingComponent<T>) {
+			for (const T& object : data) {
+				object.Save(writer);
+			}
+		}
+		else if constexpr (std::is_trivially_copyable_v<T>) {
+			writer.WriteArray(data.data(), data.size());
+		}
+		else if constexpr (ReflectedComponent<T>) {
+			for (const T& object : data) {
+				SaveFields(writer, &object, ComponentMetadata<T>::GetFields());
+			}
+		}
 	}
 
-	void Set(int entityId, T object) {
-		if (entityIdToIndex.find(entityId) != entityIdToIndex.end()) {
+	void Load(SnapshotReader& reader, std::span<const int> entityIds, std::uint32_t tick) override {
+		Clear();
+		if constexpr (IsSnapshotSerializable<T>) {
+			LoadEntityIds(entityIds, tick);
+			data.resize(entityIds.size());
+			if constexpr (SelfSerializingComponent<T>) {
+				for (T& object : data) {
+					object.Load(reader);
+				}
+			}
+			else if constexpr (std::is_trivially_copyable_v<T>) {
+				reader.ReadArray(data.data(), data.size());
+			}
+			else {
+				for (T& object : data) {
+					LoadFields(reader, &object, ComponentMetadata<T>::GetFields());
+				}
+			}
+		}
+	}
+
+	// tick = registry tick the component is stamped with, a replaced component counts as changed
+	void Set(int entityId, T object, std::uint32_t tick = 0) {
+		if (Contains(entityId)) {
 			// if element already exists, replace the object
-			int index = entityIdToIndex[entityId];
-			data[index] = object;
+			const int index = IndexOf(entityId);
+			data[index] = std::move(object);
+			changedTicks[index] = tick;
 		}
 		else {
-			// add new object, track entity id and vector index
-			int index = size;
-			entityIdToIndex.emplace(entityId, index);
-			indexToEntityId.emplace(index, entityId);
-			if (index >= data.capacity()) {
-				// resize if data is not big enough
-				data.resize(size * 2);
+			// add new object at the end of the packed array
+			Insert(entityId);
+			if (data.size() == data.capacity()) {
+				growthCount++;
 			}
-			data[index] = object;
-			size++;
+			data.push_back(std::move(object));
+			addedTicks.push_back(tick);
+			changedTicks.push_back(tick);
 		}
 	}
 
 	void Remove(int entityId) {
-		// copy last element to the deleted position to keep the array packed
-		int indexOfRemoved = entityIdToIndex[entityId];
-		int indexOfLast = size - 1;
-		data[indexOfRemoved] = data[indexOfLast];
-
-		// update the index-entity maps to point to correct elements
-		int entityIdOfLastElement = indexToEntityId[indexOfLast];
-		entityIdToIndex[entityIdOfLastElement] = indexOfRemoved;
-		indexToEntityId[indexOfRemoved] = entityIdOfLastElement;
-
-		entityIdToIndex.erase(entityId);
-		indexToEntityId.erase(indexOfLast);
-
-		size--;
+		// move last element to the deleted position to keep the array packed
+		const int indexOfRemoved = Erase(entityId);
+		if (indexOfRemoved != static_cast<int>(data.size()) - 1) {
+			data[indexOfRemoved] = std::move(data.back());
+			addedTicks[indexOfRemoved] = addedTicks.back();
+			changedTicks[indexOfRemoved] = changedTicks.back();
+		}
+		data.pop_back();
+		addedTicks.pop_back();
+		changedTicks.pop_back();
 	}
 
 	void RemoveEntityFromPool(int entityId) override {
-		if (entityIdToIndex.find(entityId) != entityIdToIndex.end()) {
+		if (Contains(entityId)) {
 			Remove(entityId);
 		}
 	}
 
 	T& Get(int entityId) {
-		int index = entityIdToIndex[entityId];
-		return static_cast<T&>(data[index]);
+		return data[IndexOf(entityId)];
+	}
+
+	const T& Get(int entityId) const {
+		return data[IndexOf(entityId)];
 	}
 
 	T& operator [] (unsigned int index) {
 		return data[index];
 	}
+
+	// objects in packed order
+	const std::vector<T>& GetData() const {
+		return data;
+	}
+
+	int GetCapacity() const override {
+		return static_cast<int>(data.capacity());
+	}
+
+	size_t GetComponentBytes() const override {
+		return data.capacity() * sizeof(T);
+	}
+
+protected:
+	void SwapSlots(int a, int b) override {
+		std::swap(data[a], data[b]);
+		std::swap(addedTicks[a], addedTicks[b]);
+		std::swap(changedTicks[a], changedTicks[b]);
+		SwapEntries(a, b);
+	}
+
 private:
-	// track vector of objects and current number of elements
+	// packed objects, data[i] belongs to GetEntityIds()[i]
 	std::vector<T> data;
-	int size;
+};
+
+/*
+ SystemEntities
+ Non owning view over the entities of a system, iterating it never copies the
+ entity list or allocates. Entities created, killed or changed while a system
+ iterates only join or leave systems in the next Registry::Update(), so the view
+ stays the same for the whole loop
+*/
+class SystemEntities {
+public:
+	class Iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Entity;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Entity*;
+		using reference = Entity;
+
+		Iterator(const EntityHandle* handle, class Registry* registry) : handle(handle), registry(registry) {}
+
+		Entity operator * () const {
+			Entity entity(*handle);
+			entity.registry = registry;
+			return entity;
+		}
+
+		Iterator& operator ++ () {
+			++handle;
+			return *this;
+		}
+
+		Iterator operator ++ (int) {
+			Iterator previous = *this;
+			++handle;
+			return previous;
+		}
+
+		bool operator == (const Iterator& other) const { return handle == other.handle; }
+		bool operator != (const Iterator& other) const { return handle != other.handle; }
+
+	private:
+		const EntityHandle* handle;
+		class Registry* registry;
+	};
+
+	SystemEntities(const std::vector<EntityHandle>& handles, class Registry* registry) : handles(handles), registry(registry) {}
+
+	Iterator begin() const { return Iterator(handles.data(), registry); }
+	Iterator end() const { return Iterator(handles.data() + handles.size(), registry); }
+	size_t size() const { return handles.size(); }
+	bool empty() const { return handles.empty(); }
+
+	Entity operator [] (size_t index) const {
+		Entity entity(handles[index]);
+		entity.registry = registry;
+		return entity;
+	}
+
+private:
+	const std::vector<EntityHandle>& handles;
+	class Registry* registry;
+};
+
+// How a system uses a component type, used to decide which systems can run at the same time
+enum class ComponentAccess {
+	Read,
+	Write
+};
+
+/*
+ System
+ The system processes entities that contain a specific signature
+*/
+class System {
+public:
+	System() = default;
+	virtual ~System() = default;
+
+	void AddEntityToSystem(Entity entity);
+	void RemoveEntityFromSystem(Entity entity);
+	// remove a batch of entities, each one is swapped with the last entity of the system
+	void RemoveEntitiesFromSystem(const std::vector<Entity>& entitiesToRemove);
+	void RemoveAllEntitiesFromSystem();
+	bool HasEntity(Entity entity) const;
+	SystemEntities GetSystemEntities() const;
+	int GetEntityCount() const;
+	// bytes reserved for the entity list of the system
+	size_t GetEntityBytes() const;
+	// bumped whenever an entity joins or leaves the system, or the entity list is reordered
+	std::uint32_t GetEntityLayoutVersion() const;
+	const Signature& GetComponentSignature() const;
+
+	// define component type entity must have to be considered by system, write access unless told otherwise
+	template <typename TComponent> void RequireComponent(ComponentAccess access = ComponentAccess::Write);
+	// declare a component type the system uses without requiring it, e.g. from an event handler
+	template <typename TComponent> void AccessComponent(ComponentAccess access);
+	// declare that the system creates entities or changes tags and groups, it then runs alone
+	void RequireExclusiveAccess();
+
+	const Signature& GetReadSignature() const;
+	const Signature& GetWriteSignature() const;
+	bool HasExclusiveAccess() const;
+	// true if the two systems touch the same component and at least one of them writes it
+	bool ConflictsWith(const System& other) const;
+
+	/*
+	 Get a required component through the pool cached when the system was added,
+	 falls back to the registry lookup when the registry doesn't use pools.
+	 Read only, writes go through GetMutableComponent()
+	*/
+	template <typename TComponent> ConstComponentReference<TComponent> GetComponent(Entity entity) const;
+	// same as GetComponent() but marks the component as changed at the current registry tick
+	template <typename TComponent> ComponentReference<TComponent> GetMutableComponent(Entity entity) const;
+
+	/*
+	 Check if the component was added or written through a tracked accessor since
+	 the start of the system's previous run, see MarkRun()
+	 @return bool
+	*/
+	template <typename TComponent> bool HasChanged(Entity entity) const;
+	// remember the current registry tick, call once per run of a system that uses HasChanged()
+	void MarkRun();
+	// registry tick of the previous MarkRun(), components changed at or after it count as changed
+	std::uint32_t GetLastRunTick() const { return lastRunTick; }
+
+	// cache non owning pointers to the pools of the required components
+	void SetComponentPools(const std::vector<class IPool*>& pools);
+
+	// registry that owns the system, set when the system is added
+	class Registry* registry = nullptr;
+	// copies the system for Registry::Clone(), set by AddSystem() if the system type can be copied
+	System* (*copySystem)(const System& system) = nullptr;
+
+private:
+	Signature componentSignature;
+	// registry tick of the previous MarkRun(), 0 until the first run so everything counts as changed
+	std::uint32_t lastRunTick = 0;
+	Signature readSignature;
+	Signature writeSignature;
+	bool exclusiveAccess = false;
+	// Vector index = component id, nullptr for components the system doesn't require
+	std::vector<class IPool*> componentPools;
+	// entity handles packed in a sparse set indexed by entity id
+	Pool<EntityHandle> entities;
+};
+
+/*
+ Archetype
+ Stores every entity that has exactly the same signature. Entities are packed
+ into fixed size chunks, each chunk holds the entity handles followed by one
+ array per component type, so iterating a chunk reads memory linearly
+*/
+class Archetype {
+public:
+	static constexpr size_t CHUNK_SIZE = 16 * 1024;
+	static constexpr size_t CHUNK_ALIGNMENT = 64;
+
+	Archetype(const Signature& signature);
+	~Archetype();
+
+	Archetype(const Archetype&) = delete;
+	Archetype& operator = (const Archetype&) = delete;
+
+	const Signature& GetSignature() const { return signature; }
+	int GetEntityCount() const { return entityCount; }
+	int GetChunkCount() const { return static_cast<int>(chunks.size()); }
+	int GetChunkCapacity() const { return chunkCapacity; }
+	size_t GetChunkBytes() const { return chunkBytes; }
+
+	int GetChunkEntityCount(int chunk) const {
+		return std::min(chunkCapacity, entityCount - chunk * chunkCapacity);
+	}
+
+	EntityHandle* GetHandles(int chunk) const {
+		return reinterpret_cast<EntityHandle*>(chunks[chunk]);
+	}
+
+	// returns the start of the component array of a chunk
+	void* GetColumn(int chunk, int componentId) const {
+		return chunks[chunk] + columnOffsets[columnPerComponent[componentId]];
+	}
+
+	void* GetComponent(int row, int componentId) const {
+		const int column = columnPerComponent[componentId];
+		return chunks[row / chunkCapacity] + columnOffsets[column] + (row % chunkCapacity) * columnSizes[column];
+	}
+
+	EntityHandle GetHandle(int row) const {
+		return GetHandles(row / chunkCapacity)[row % chunkCapacity];
+	}
+
+	const std::vector<int>& GetComponentIds() const { return componentIds; }
+
+	// append a row with uninitialized components and return its index
+	int PushRow(EntityHandle handle);
+	/*
+	 Fill a row whose components were already destroyed or moved out with the last row
+	 @return handle of the entity moved into the row, or the removed handle if the row was the last one
+	*/
+	EntityHandle EraseRow(int row);
+
+private:
+	// compute column offsets for a chunk capacity, returns false if they don't fit
+	bool LayoutColumns(int capacity);
+
+	Signature signature;
+	std::vector<int> componentIds;
+	std::array<int, MAX_COMPONENTS> columnPerComponent;
+	std::vector<size_t> columnOffsets;
+	std::vector<size_t> columnSizes;
+	size_t chunkBytes = CHUNK_SIZE;
+	int chunkCapacity = 0;
+	int entityCount = 0;
+	std::vector<std::byte*> chunks;
+
+	// cached archetype transitions when adding or removing a component
+	std::array<Archetype*, MAX_COMPONENTS> addEdges{};
+	std::array<Archetype*, MAX_COMPONENTS> removeEdges{};
+
+	friend class ArchetypeStorage;
+};
+
+/*
+ ArchetypeStorage
+ Component storage that groups entities by signature. Adding or removing a
+ component moves the entity (and its components) to the matching archetype
+*/
+class ArchetypeStorage {
+public:
+	ArchetypeStorage() = default;
+	~ArchetypeStorage();
+
+	void AddEntity(Entity entity);
+	// destroy all the components of an entity and remove it from its archetype
+	void RemoveEntity(int entityId);
+	// destroy every component and archetype
+	void Clear();
+	// replace the contents with copies of the entities and components of another storage
+	void CopyFrom(const ArchetypeStorage& other);
+
+	/*
+	 Move an entity to the archetype that also contains the component
+	 @return uninitialized memory where the new component must be constructed
+	*/
+	void* AddComponent(int entityId, int componentId);
+	/*
+	 Move an entity straight to the archetype that also contains all the given components,
+	 the components it didn't have yet are uninitialized memory that must be constructed
+	*/
+	void AddComponents(int entityId, const Signature& components);
+	void RemoveComponent(int entityId, int componentId);
+	void* GetComponent(int entityId, int componentId) const;
 
-	// maps to track entity ids per index so vector is always packed
-	std::unordered_map<int, int> entityIdToIndex;
-	std::unordered_map<int, int> indexToEntityId;
+	const std::vector<std::unique_ptr<Archetype>>& GetArchetypes() const { return archetypes; }
+
+private:
+	struct EntityLocation {
+		Archetype* archetype = nullptr;
+		int row = -1;
+	};
+
+	Archetype* GetArchetype(const Signature& signature);
+	// move an entity row to another archetype, components the target doesn't have are destroyed
+	void MoveEntity(int entityId, Archetype* target);
+	// destroy the components of a row and close the hole it leaves
+	void DestroyRow(Archetype* archetype, int row);
+	void EraseRow(Archetype* archetype, int row);
+
+	// Vector index = entity id
+	std::vector<EntityLocation> entityLocations;
+	std::vector<std::unique_ptr<Archetype>> archetypes;
+	std::unordered_map<Signature, Archetype*> archetypePerSignature;
+};
+
+/*
+ StorageMode
+ Selects how the registry lays out component data. Pools keep one sparse set per
+ component type, archetypes keep entities with the same signature together in chunks
+*/
+enum class StorageMode {
+	Pools,
+	Archetypes
 };
 
+/*
+ ComponentEvent
+ Lifecycle events of a component type that observers can subscribe to.
+ Removed is also sent for every component of a killed entity
+*/
+enum class ComponentEvent {
+	Added,
+	Replaced,
+	Removed
+};
+
+// receives every entity an event happened to since the last dispatch, handles may be stale
+using ComponentObserver = std::function<void(std::span<const Entity> entities)>;
+
+template <typename ...TComponents> class ComponentView;
+class CommandBuffer;
+class Prefab;
+
 /*
  Registry
  The registry manages the creation and destruction of entities, as well as
@@ -198,8 +860,12 @@ private:
 */
 class Registry {
 public:
-	Registry() { Logger::Log("Registry constuctor called"); }
-	~Registry() { Logger::Log("Registry deconstuctor called"); }
+	Registry(StorageMode storageMode = StorageMode::Pools);
+	~Registry();
+
+	StorageMode GetStorageMode() const { return storageMode; }
+	// advanced by every Update(), added and written components are stamped with it
+	std::uint32_t GetTick() const { return currentTick; }
 
 	void Update();
 
@@ -209,25 +875,166 @@ public:
 	 @return entity
 	*/
 	Entity CreateEntity();
+	/*
+	 Create count entities at once, logged once for the whole batch
+	 @return created entities
+	*/
+	std::vector<Entity> CreateEntities(int count);
 	void KillEntity(Entity entity);
+	// check that the entity handle still refers to a live entity
+	bool IsEntityAlive(Entity entity) const;
+	// handle of the entity that uses the id now, a free id has no components, tags or groups
+	Entity GetEntity(int entityId);
+	// number of entity ids handed out so far, free ids included
+	int GetEntityIdCount() const { return numEntities; }
+	/*
+	 Measure the memory and occupancy of the pools, systems, archetypes and entity
+	 bookkeeping. Walks every pool, call it between updates rather than from systems
+	 @return RegistryStats
+	*/
+	RegistryStats GetStats() const;
+	/*
+	 Remove every entity with its components, tags and groups right away, systems
+	 stay registered. Observers hear about the removed components in the next Update()
+	*/
+	void Clear();
+	/*
+	 Copy every entity with its components, tags, groups and system memberships into a
+	 new registry, e.g. to simulate ahead or to keep a state to roll back to. Pools are
+	 shared between the two registries and copied by whichever one changes a shared pool
+	 first: GetMutableComponent(), GetMutablePool(), non const views, and the
+	 SystemScheduler for the pools the systems of a stage write, before the stage starts.
+	 GetComponent() and GetPool() only read. Systems run outside the scheduler need
+	 UnshareWrittenPools() first. Observers and pending commands aren't copied. Archetype
+	 storage is copied outright. Clone right after Update()
+	 @return the clone, nullptr if a component or system type can't be copied
+	*/
+	std::unique_ptr<Registry> Clone() const;
 
+	/*
+	 Write every entity with its components, tags and groups into a binary snapshot,
+	 see Snapshot.hpp. Pending commands and kills aren't part of it, so save right
+	 after Update()
+	 @return snapshot bytes
+	*/
+	std::vector<std::byte> SaveSnapshot() const;
+	/*
+	 Replace the world with a snapshot. Component types are matched by name and must
+	 have been used before loading, e.g. by a system that requires them, pools of
+	 unknown types are skipped. Loaded components are stamped with the current tick
+	 and the entities join systems in the next Update()
+	 @return false if the snapshot is invalid, the registry is left empty if it is damaged past the header
+	*/
+	bool LoadSnapshot(std::span<const std::byte> snapshot);
+	bool SaveSnapshotToFile(const std::string& filePath) const;
+	bool LoadSnapshotFromFile(const std::string& filePath);
+
+	/*
+	 Command buffer of the calling thread, the commands recorded in it are
+	 applied at the start of the next registry Update()
+	 @return CommandBuffer&
+	*/
+	CommandBuffer& GetCommandBuffer();
+
+	/*
+	 Tag and group names are interned to small ids that are the same in every registry,
+	 checks by id only compare integers. Look up the ids a system checks every frame
+	 once, e.g. in its constructor
+	 @return id, GetGroupId() returns -1 once MAX_GROUPS groups are in use
+	*/
+	static int GetTagId(const std::string& tag);
+	static int GetGroupId(const std::string& group);
+	static const std::string& GetTagName(int tagId);
+	static const std::string& GetGroupName(int groupId);
+
+	// an entity has one tag and a tag names one entity, a tag that is taken stays with its entity
 	void TagEntity(Entity entity, const std::string& tag);
+	void TagEntity(Entity entity, int tagId);
 	bool EntityHasTag(Entity entity, const std::string& tag) const;
+	bool EntityHasTag(Entity entity, int tagId) const;
 	Entity GetEntityByTag(const std::string& tag) const;
 	void RemoveEntityTag(Entity entity);
 
+	// an entity can belong to several groups
 	void GroupEntity(Entity entity, const std::string& group);
+	void GroupEntity(Entity entity, int groupId);
+	// add every entity to the group with a single group lookup
+	void GroupEntities(std::span<const Entity> entities, const std::string& group);
 	bool EntityBelongsToGroup(Entity entity, const std::string& group) const;
-	std::vector<Entity> GetEntitiesByGroup(const std::string& group) const;
+	bool EntityBelongsToGroup(Entity entity, int groupId) const;
+	// entities of the group in no particular order, the span is valid until the group changes
+	std::span<const Entity> GetEntitiesByGroup(const std::string& group) const;
+	std::span<const Entity> GetEntitiesByGroup(int groupId) const;
+	void RemoveEntityFromGroup(Entity entity, int groupId);
+	// remove the entity from every group it belongs to
 	void RemoveEntityGroup(Entity entity);
 
+	/*
+	 Create an entity from a prefab, see Prefab.hpp. Every override is a component
+	 that is used instead of the prefab's copy or added next to it
+	 @return entity
+	*/
+	template <typename ...TOverrides> Entity Instantiate(const Prefab& prefab, TOverrides&& ...overrides);
+	/*
+	 Create count entities from a prefab, overrides[i] goes to the i-th entity. Each
+	 prefab component is copied into its pool in one pass for the whole batch
+	 @return created entities, empty if an override span holds fewer than count components
+	*/
+	template <typename ...TOverrides> std::vector<Entity> InstantiateBatch(const Prefab& prefab, int count, std::span<const TOverrides> ...overrides);
+	// add the components, tag and group of a prefab to an existing entity
+	template <typename ...TOverrides> void ApplyPrefab(Entity entity, const Prefab& prefab, TOverrides&& ...overrides);
+
 	// Component management
 	template <typename TComponent, typename ...TArgs> void AddComponent(Entity entity, TArgs&& ...args);
+	// add components[i] to entities[i], the pool grows once for the whole batch
+	template <typename TComponent> void AddComponents(std::span<const Entity> entities, std::span<const TComponent> components);
 	// remove component from entity
 	template <typename TComponent> void RemoveComponent(Entity entity);
 	// check if entity has a component
 	template <typename TComponent> bool HasComponent(Entity entity) const;
-	template <typename TComponent> TComponent& GetComponent(Entity entity) const;
+	// read only, the pool can be shared with a clone, see Clone()
+	template <typename TComponent> ConstComponentReference<TComponent> GetComponent(Entity entity) const;
+	// write access that stamps the component with the current tick so change queries see it
+	template <typename TComponent> ComponentReference<TComponent> GetMutableComponent(Entity entity);
+	/*
+	 Check if the component was added or written through a tracked accessor at or after tick.
+	 Archetype storage doesn't track changes and always answers true
+	 @return bool
+	*/
+	template <typename TComponent> bool HasComponentChangedSince(Entity entity, std::uint32_t tick) const;
+	// returns the pool of a component type for reading, or nullptr if no entity ever had the component
+	template <typename TComponent> const Pool<TComponent>* GetPool() const;
+
+	/*
+	 Type erased access by component id, for generic code that goes through the
+	 ComponentInfo of a type, e.g. an inspector walking the reflected fields.
+	 CopyComponent() constructs a copy of the entity's component in uninitialized
+	 memory of ComponentInfo::size bytes, destroy it with ComponentInfo::destroy
+	*/
+	bool HasComponent(Entity entity, int componentId) const;
+	void CopyComponent(Entity entity, int componentId, void* destination) const;
+	// same as GetPool() but copies the pool first if it is shared with a clone, for writing
+	template <typename TComponent> Pool<TComponent>* GetMutablePool();
+
+	/*
+	 Iterate every entity that has the requested components, see View.hpp
+	 e.g. View<TransformComponent, const SpriteComponent, Optional<HealthComponent>, Exclude<ProjectileComponent>>()
+	*/
+	template <typename ...TComponents> ComponentView<TComponents...> View();
+
+	/*
+	 Subscribe to component lifecycle events. Events are queued while the frame
+	 runs and every observer is called once per Update() with the whole batch
+	*/
+	template <typename TComponent> void OnAdd(ComponentObserver observer);
+	template <typename TComponent> void OnReplace(ComponentObserver observer);
+	template <typename TComponent> void OnRemove(ComponentObserver observer);
+
+	/*
+	 Call func(count, handles, components...) for every run of entities that have all the
+	 components. In archetype storage a run is a whole chunk, in pool storage a single entity
+	*/
+	template <typename ...TComponents, typename TFunc> void ForEachChunk(TFunc func);
 
 	// System management
 
@@ -250,38 +1057,181 @@ public:
 	*/
 	template <typename TSystem> TSystem& GetSystem() const;
 
+	// create the pools a system requires and hand it pointers to them, pools it writes are copied if shared
+	void ResolveSystemPools(System& system);
+	/*
+	 Copy the pools the system writes that are shared with a clone, and point the systems
+	 at the copies. Call from the thread that owns the registry before the system runs,
+	 the scheduler does it for every stage
+	*/
+	void UnshareWrittenPools(const System& system);
+
 	// Add and remove entities from systems
 	void AddEntityToSystems(Entity entity);
+	/*
+	 Systems whose signature is contained in the signature with the given id, computed
+	 once per distinct signature and cached until systems are added or removed
+	 @return matching systems
+	*/
+	const std::vector<System*>& GetMatchingSystems(int signatureId);
 	void RemoveEntityFromSystems(Entity entity);
+	void RemoveEntitiesFromSystems(const std::vector<Entity>& entitiesToRemove);
 
 private:
+	template <typename ...TComponents> friend class ComponentView;
+
+	// apply the recorded commands of every thread in sort key order
+	void ApplyCommandBuffers();
+
+	// pool of a component type, created on first use
+	template <typename TComponent> Pool<TComponent>* GetOrCreatePool();
+	IPool* GetOrCreatePool(int componentId);
+	/*
+	 Copy a pool that is shared with a clone so this registry can change it
+	 @return true if the pool was copied
+	*/
+	bool CopySharedPool(int componentId);
+	// pool about to be changed, copied first if it is shared, nullptr if there is none
+	IPool* UnsharePool(int componentId);
+	// hand a system pointers to the current pools of the components it requires
+	void CacheSystemPools(System& system);
+	// reserve the id and generation of a new entity
+	Entity AllocateEntity();
+
+	/*
+	 Copy the prefab components that aren't overridden onto the entities, with archetype
+	 storage every entity moves to its final archetype once. Signatures are updated
+	 afterwards by FinishPrefabEntities(), so overrides can still tell added from replaced
+	*/
+	void AddPrefabComponents(std::span<const Entity> entities, const Prefab& prefab, const Signature& overridden);
+	template <typename TComponent, typename TValue> void SetPrefabOverride(int entityId, TValue&& value);
+	// set the signatures, queue the events and apply the tag and group of the prefab
+	void FinishPrefabEntities(std::span<const Entity> entities, const Prefab& prefab, const Signature& overridden);
+
+	// write the entity ids and components of one pool as a snapshot pool record
+	void SavePool(SnapshotWriter& writer, int componentId, const IPool& pool) const;
+	// validate the pool records of a snapshot before anything is loaded, see LoadSnapshot()
+	bool CheckSnapshotPools(SnapshotReader& reader, const SnapshotHeader& header, const std::vector<bool>& aliveEntities) const;
+
+	void AddObserver(int componentId, ComponentEvent event, ComponentObserver observer);
+	// queue a lifecycle event, events of components nobody observes are dropped right away
+	void QueueComponentEvent(int componentId, ComponentEvent event, Entity entity) {
+		if (componentId < componentObservers.size()) {
+			ComponentObservers& observers = componentObservers[componentId];
+			const int eventIndex = static_cast<int>(event);
+			if (!observers.observers[eventIndex].empty()) {
+				observers.pendingEntities[eventIndex].push_back(entity);
+			}
+		}
+	}
+	// call the observers with the events queued since the last Update()
+	void DispatchComponentEvents();
+
+	// queue the entity for system matching in the next Update(), once per entity
+	void MarkEntityDirty(int entityId) {
+		if (!entityMemberships[entityId].dirty) {
+			entityMemberships[entityId].dirty = true;
+			dirtyEntities.push_back(entityId);
+		}
+	}
+	// move dirty entities between systems according to how their signature changed
+	void UpdateSystemMembership();
+
+	const Signature& GetEntitySignature(int entityId) const {
+		return signatureTable.Get(entitySignatures[entityId]);
+	}
+
 	int numEntities = 0;
+	std::uint32_t currentTick = 1;
+
+	StorageMode storageMode;
+	// identifies the registry in the per thread command buffer lookup, never reused
+	const std::uint64_t registryId;
+
+	// Component data of every entity when the registry uses archetype storage
+	ArchetypeStorage archetypeStorage;
 
 	// Vector of component pools, each pool contains all the data for a certain component type
 	// Vector index = component type id
 	// Pool index = entity id
+	// Pools are shared with clones until one side changes them, see Clone()
 	std::vector<std::shared_ptr<IPool>> componentPools;
 
-	// Vector of component signatures per entity, saying which component is used for each entity
+	// Id in signatureTable of the component signature of every entity, saying which component is used for each entity
 	// Vector index = entity id
-	std::vector<Signature> entityComponentSignatures;
+	std::vector<int> entitySignatures;
+	// Every distinct signature an entity had, one entry per combination of components instead of one per entity
+	SignatureTable signatureTable;
 
-	// Unordered map of systems
-	std::unordered_map<std::type_index, std::shared_ptr<System>> systems;
+	// Current generation of every entity id, bumped when the id is freed
+	// Vector index = entity id
+	std::vector<std::uint32_t> entityGenerations;
 
-	// Set of entities that are flagged to be added in the next registry Update()
-	std::set<Entity> entitiesToBeAdded;
+	// Unordered map of systems
+	std::unordered_map<std::type_index, std::unique_ptr<System>> systems;
+
+	struct EntityMembership {
+		// signature id the entity had when it was last matched against the systems
+		int signatureId = SignatureTable::EMPTY;
+		bool inSystems = false;
+		bool dirty = false;
+	};
+	// Vector index = entity id
+	std::vector<EntityMembership> entityMemberships;
+	// Ids of entities created or whose signature changed since the last Update(), in order
+	std::vector<int> dirtyEntities;
+	// Matching systems per signature id, cleared when systems change. A deque so the
+	// lists handed out by GetMatchingSystems() stay valid while new ids are added
+	std::deque<std::optional<std::vector<System*>>> systemsPerSignature;
+
+	struct ComponentObservers {
+		// index = ComponentEvent
+		std::array<std::vector<ComponentObserver>, 3> observers;
+		std::array<std::vector<Entity>, 3> pendingEntities;
+	};
+	// Vector index = component type id
+	std::vector<ComponentObservers> componentObservers;
+	// batch being dispatched, observers can queue new events meanwhile
+	std::vector<Entity> dispatchedEntities;
 	// Set of entities that are flagged to be removed in the next registry Update()
 	std::set<Entity> entitiesToBeKilled;
+	// KillEntity() can be called from systems running on worker threads
+	std::mutex killMutex;
+	// Entities being killed by the current Update(), reused between frames
+	std::vector<Entity> killedEntities;
+
+	// One command buffer per thread that asked for one
+	std::vector<std::unique_ptr<CommandBuffer>> commandBuffers;
+	// index in commandBuffers of the buffer of each thread
+	std::unordered_map<std::thread::id, int> threadBufferIndices;
+	std::mutex commandBuffersMutex;
+	struct PendingCommand {
+		std::uint64_t sortKey;
+		int buffer;
+		int command;
+	};
+	// commands of all buffers merged by ApplyCommandBuffers(), reused between frames
+	std::vector<PendingCommand> pendingCommands;
+
+	// Tag id of every entity, -1 if the entity has no tag
+	// Vector index = entity id
+	std::vector<int> entityTags;
+	// Entity named by every tag
+	// Vector index = tag id
+	std::vector<std::optional<Entity>> entityPerTag;
 
-	std::unordered_map<std::string, Entity> entityPerTag;
-	std::unordered_map<int, std::string> tagPerEntity;
-
-	std::unordered_map<std::string, std::set<Entity>> entitiesPerGroup;
-	std::unordered_map<int, std::string> groupPerEntity;
-
-
-	// List of free ids
+	// Groups of every entity
+	// Vector index = entity id
+	std::vector<GroupMask> entityGroups;
+	struct GroupMembers {
+		std::vector<Entity> entities;
+		// position of every member in entities, vector index = entity id
+		std::vector<int> entityIndices;
+	};
+	// Array index = group id
+	std::array<GroupMembers, MAX_GROUPS> entitiesPerGroup;
+
+	// List of free ids, each id is pushed once when its entity is killed
 	std::deque<int> freeIds;
 };
 
@@ -291,10 +1241,66 @@ private:
 * ********************************
 */
 
+template <typename T>
+IPool* Component<T>::CreatePool() {
+	return new Pool<T>();
+}
+
+template <typename T>
+void Component<T>::CopyToPool(IPool& pool, int entityId, const void* component) {
+	static_cast<Pool<T>&>(pool).Set(entityId, *static_cast<const T*>(component));
+}
+
+template <typename T>
+void Component<T>::ConstructFromPool(const IPool& pool, int entityId, void* destination) {
+	new (destination) T(static_cast<const Pool<T>&>(pool).Get(entityId));
+}
+
 template <typename TComponent>
-void System::RequireComponent() {
+void System::RequireComponent(ComponentAccess access) {
 	const int componentId = Component<TComponent>::GetId();
 	componentSignature.set(componentId);
+	AccessComponent<TComponent>(access);
+}
+
+template <typename TComponent>
+void System::AccessComponent(ComponentAccess access) {
+	const int componentId = Component<TComponent>::GetId();
+	if (access == ComponentAccess::Write) {
+		writeSignature.set(componentId);
+	}
+	else {
+		readSignature.set(componentId);
+	}
+}
+
+template <typename TComponent>
+ConstComponentReference<TComponent> System::GetComponent(Entity entity) const {
+	const int componentId = Component<TComponent>::GetId();
+	if (componentId < componentPools.size() && componentPools[componentId]) {
+		return static_cast<const Pool<TComponent>*>(componentPools[componentId])->Get(entity.GetId());
+	}
+	return registry->GetComponent<TComponent>(entity);
+}
+
+template <typename TComponent>
+ComponentReference<TComponent> System::GetMutableComponent(Entity entity) const {
+	const int componentId = Component<TComponent>::GetId();
+	if (componentId < componentPools.size() && componentPools[componentId]) {
+		Pool<TComponent>* pool = static_cast<Pool<TComponent>*>(componentPools[componentId]);
+		pool->MarkChanged(entity.GetId(), registry->GetTick());
+		return pool->Get(entity.GetId());
+	}
+	return registry->GetMutableComponent<TComponent>(entity);
+}
+
+template <typename TComponent>
+bool System::HasChanged(Entity entity) const {
+	const int componentId = Component<TComponent>::GetId();
+	if (componentId < componentPools.size() && componentPools[componentId]) {
+		return componentPools[componentId]->GetChangedTick(entity.GetId()) >= lastRunTick;
+	}
+	return registry->HasComponentChangedSince<TComponent>(entity, lastRunTick);
 }
 
 template <typename TComponent, typename ...TArgs>
@@ -302,40 +1308,62 @@ void Registry::AddComponent(Entity entity, TArgs&& ...args) {
 	const int componentId = Component<TComponent>::GetId();
 	const int entityId = entity.GetId();
 
-	// If component id is greater than the current size of the componentPool, resize the vector
-	if (componentId >= componentPools.size())
-		componentPools.resize(componentId + 1, nullptr);
-
-	// If we don't have a Pool for that component type, create one
-	if (!componentPools[componentId]) {
-		std::shared_ptr<Pool<TComponent>> newComponentPool = std::make_shared<Pool<TComponent>>();
-		componentPools[componentId] = newComponentPool;
+	if (storageMode == StorageMode::Archetypes) {
+		if (GetEntitySignature(entityId).test(componentId)) {
+			// replace the existing component in place
+			*static_cast<TComponent*>(archetypeStorage.GetComponent(entityId, componentId)) = TComponent(std::forward<TArgs>(args)...);
+		}
+		else {
+			// move the entity to its new archetype and construct the component there
+			new (archetypeStorage.AddComponent(entityId, componentId)) TComponent(std::forward<TArgs>(args)...);
+		}
 	}
+	else {
+		// Get the pool of component values for that component type
+		Pool<TComponent>* componentPool = GetOrCreatePool<TComponent>();
 
-	// Get the pool of component values for that component type
-	std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-
-	// Create a new component object of the type T and forward the parameters to the constructor
-	TComponent newComponent(std::forward<TArgs>(args)...);
+		// Create a new component object of the type T and forward the parameters to the constructor
+		TComponent newComponent(std::forward<TArgs>(args)...);
 
-	// Add the new component to the component pool list
-	componentPool->Set(entityId, newComponent);
+		// Add the new component to the component pool list
+		componentPool->Set(entityId, std::move(newComponent), currentTick);
+	}
 
 	// Change the component signature of the entity and set the component id on the bitset to 1
-	entityComponentSignatures[entityId].set(componentId);
+	if (!GetEntitySignature(entityId).test(componentId)) {
+		entitySignatures[entityId] = signatureTable.With(entitySignatures[entityId], componentId);
+		MarkEntityDirty(entityId);
+		QueueComponentEvent(componentId, ComponentEvent::Added, entity);
+	}
+	else {
+		QueueComponentEvent(componentId, ComponentEvent::Replaced, entity);
+	}
 
 	Logger::Log("Component id: " + std::to_string(componentId) + " was added to entity id " + std::to_string(entityId));
 }
 
 template <typename TComponent>
 void Registry::RemoveComponent(Entity entity) {
+	// nothing to remove, and no Removed event for observers
+	if (!HasComponent<TComponent>(entity)) {
+		return;
+	}
+
 	const int componentId = Component<TComponent>::GetId();
 	const int entityId = entity.GetId();
 
-	std::shared_ptr<Pool<TComponent>> componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
-	componentPool->Remove(entityId);
+	if (storageMode == StorageMode::Archetypes) {
+		archetypeStorage.RemoveComponent(entityId, componentId);
+	}
+	else {
+		Pool<TComponent>* componentPool = static_cast<Pool<TComponent>*>(UnsharePool(componentId));
+		componentPool->Remove(entityId);
+	}
 
-	entityComponentSignatures[entityId].set(componentId, false);
+	entitySignatures[entityId] = signatureTable.Without(entitySignatures[entityId], componentId);
+	// the entity leaves the systems that require the component in the next Update()
+	MarkEntityDirty(entityId);
+	QueueComponentEvent(componentId, ComponentEvent::Removed, entity);
 
 	Logger::Log("Component id: " + std::to_string(componentId) + " was removed from entity id " + std::to_string(entityId));
 }
@@ -344,16 +1372,183 @@ template <typename TComponent>
 bool Registry::HasComponent(Entity entity) const {
 	const int componentId = Component<TComponent>::GetId();
 	const int entityId = entity.GetId();
-	return entityComponentSignatures[entityId].test(componentId);
+	return GetEntitySignature(entityId).test(componentId);
 }
 
 template <typename TComponent>
-TComponent& Registry::GetComponent(Entity entity) const {
+ConstComponentReference<TComponent> Registry::GetComponent(Entity entity) const {
 	const int componentId = Component<TComponent>::GetId();
 	const int entityId = entity.GetId();
-	auto componentPool = std::static_pointer_cast<Pool<TComponent>>(componentPools[componentId]);
+	if (storageMode == StorageMode::Archetypes) {
+		const TComponent& component = *static_cast<const TComponent*>(archetypeStorage.GetComponent(entityId, componentId));
+		return ConstComponentReference<TComponent>(component);
+	}
+	const Pool<TComponent>* componentPool = static_cast<const Pool<TComponent>*>(componentPools[componentId].get());
 	return componentPool->Get(entityId);
- }
+}
+
+template <typename TComponent>
+ComponentReference<TComponent> Registry::GetMutableComponent(Entity entity) {
+	const int componentId = Component<TComponent>::GetId();
+	const int entityId = entity.GetId();
+	if (storageMode == StorageMode::Archetypes) {
+		TComponent& component = *static_cast<TComponent*>(archetypeStorage.GetComponent(entityId, componentId));
+		return ComponentReference<TComponent>(component);
+	}
+	Pool<TComponent>* componentPool = static_cast<Pool<TComponent>*>(UnsharePool(componentId));
+	componentPool->MarkChanged(entityId, currentTick);
+	return componentPool->Get(entityId);
+}
+
+template <typename TComponent>
+bool Registry::HasComponentChangedSince(Entity entity, std::uint32_t tick) const {
+	if (storageMode == StorageMode::Archetypes) {
+		return true;
+	}
+	// a component type that was never added has no pool, and an entity without the component has no tick
+	const int componentId = Component<TComponent>::GetId();
+	if (componentId >= componentPools.size() || !componentPools[componentId] || !componentPools[componentId]->Contains(entity.GetId())) {
+		return false;
+	}
+	return componentPools[componentId]->GetChangedTick(entity.GetId()) >= tick;
+}
+
+template <typename TComponent>
+void Registry::AddComponents(std::span<const Entity> entities, std::span<const TComponent> components) {
+	const int componentId = Component<TComponent>::GetId();
+	const size_t count = std::min(entities.size(), components.size());
+
+	if (storageMode == StorageMode::Archetypes) {
+		for (size_t i = 0; i < count; i++) {
+			const int entityId = entities[i].GetId();
+			if (GetEntitySignature(entityId).test(componentId)) {
+				*static_cast<TComponent*>(archetypeStorage.GetComponent(entityId, componentId)) = components[i];
+				QueueComponentEvent(componentId, ComponentEvent::Replaced, entities[i]);
+			}
+			else {
+				new (archetypeStorage.AddComponent(entityId, componentId)) TComponent(components[i]);
+				entitySignatures[entityId] = signatureTable.With(entitySignatures[entityId], componentId);
+				MarkEntityDirty(entityId);
+				QueueComponentEvent(componentId, ComponentEvent::Added, entities[i]);
+			}
+		}
+	}
+	else {
+		Pool<TComponent>* componentPool = GetOrCreatePool<TComponent>();
+		componentPool->Reserve(componentPool->GetSize() + static_cast<int>(count));
+		for (size_t i = 0; i < count; i++) {
+			const int entityId = entities[i].GetId();
+			componentPool->Set(entityId, components[i], currentTick);
+			if (!GetEntitySignature(entityId).test(componentId)) {
+				entitySignatures[entityId] = signatureTable.With(entitySignatures[entityId], componentId);
+				MarkEntityDirty(entityId);
+				QueueComponentEvent(componentId, ComponentEvent::Added, entities[i]);
+			}
+			else {
+				QueueComponentEvent(componentId, ComponentEvent::Replaced, entities[i]);
+			}
+		}
+	}
+
+	Logger::Log("Component id: " + std::to_string(componentId) + " was added to " + std::to_string(count) + " entities");
+}
+
+template <typename TComponent>
+void Registry::OnAdd(ComponentObserver observer) {
+	AddObserver(Component<TComponent>::GetId(), ComponentEvent::Added, std::move(observer));
+}
+
+template <typename TComponent>
+void Registry::OnReplace(ComponentObserver observer) {
+	AddObserver(Component<TComponent>::GetId(), ComponentEvent::Replaced, std::move(observer));
+}
+
+template <typename TComponent>
+void Registry::OnRemove(ComponentObserver observer) {
+	AddObserver(Component<TComponent>::GetId(), ComponentEvent::Removed, std::move(observer));
+}
+
+template <typename TComponent>
+Pool<TComponent>* Registry::GetOrCreatePool() {
+	const int componentId = Component<TComponent>::GetId();
+
+	// If component id is greater than the current size of the componentPool, resize the vector
+	if (componentId >= componentPools.size())
+		componentPools.resize(componentId + 1);
+
+	// If we don't have a Pool for that component type, create one
+	if (!componentPools[componentId]) {
+		componentPools[componentId] = std::make_shared<Pool<TComponent>>();
+	}
+	return static_cast<Pool<TComponent>*>(UnsharePool(componentId));
+}
+
+template <typename TComponent>
+const Pool<TComponent>* Registry::GetPool() const {
+	const int componentId = Component<TComponent>::GetId();
+	if (componentId >= componentPools.size()) {
+		return nullptr;
+	}
+	return static_cast<const Pool<TComponent>*>(componentPools[componentId].get());
+}
+
+template <typename TComponent>
+Pool<TComponent>* Registry::GetMutablePool() {
+	const int componentId = Component<TComponent>::GetId();
+	if (componentId >= componentPools.size()) {
+		return nullptr;
+	}
+	return static_cast<Pool<TComponent>*>(UnsharePool(componentId));
+}
+
+template <typename ...TComponents, typename TFunc>
+void Registry::ForEachChunk(TFunc func) {
+	static_assert((Pool<TComponents>::STORES_OBJECTS && ...), "ForEachChunk hands out component pointers, which pools with separate field arrays can't provide");
+
+	if (storageMode == StorageMode::Archetypes) {
+		Signature requiredSignature;
+		(requiredSignature.set(Component<TComponents>::GetId()), ...);
+
+		for (const auto& archetype : archetypeStorage.GetArchetypes()) {
+			if (!archetype->GetSignature().Contains(requiredSignature)) {
+				continue;
+			}
+			for (int chunk = 0; chunk < archetype->GetChunkCount(); chunk++) {
+				func(
+					archetype->GetChunkEntityCount(chunk),
+					static_cast<const EntityHandle*>(archetype->GetHandles(chunk)),
+					static_cast<TComponents*>(archetype->GetColumn(chunk, Component<TComponents>::GetId()))...
+				);
+			}
+		}
+		return;
+	}
+
+	// every pool must exist, otherwise no entity has all the components
+	IPool* pools[] = { GetMutablePool<TComponents>()... };
+	IPool* smallestPool = nullptr;
+	for (IPool* pool : pools) {
+		if (!pool) {
+			return;
+		}
+		if (!smallestPool || pool->GetSize() < smallestPool->GetSize()) {
+			smallestPool = pool;
+		}
+	}
+
+	// pools have no shared layout, so every entity is a run of one
+	for (int entityId : smallestPool->GetEntityIds()) {
+		bool hasAllComponents = true;
+		for (IPool* pool : pools) {
+			hasAllComponents = hasAllComponents && pool->Contains(entityId);
+		}
+		if (!hasAllComponents) {
+			continue;
+		}
+		const EntityHandle handle = Entity::MakeHandle(entityId, entityGenerations[entityId]);
+		func(1, &handle, &static_cast<Pool<TComponents>*>(componentPools[Component<TComponents>::GetId()].get())->Get(entityId)...);
+	}
+}
 
 /*
 * ********************************
@@ -377,10 +1572,15 @@ bool Entity::HasComponent() const {
 }
 
 template <typename TComponent>
-TComponent& Entity::GetComponent() const {
+ConstComponentReference<TComponent> Entity::GetComponent() const {
 	return registry->GetComponent<TComponent>(*this);
 }
 
+template <typename TComponent>
+ComponentReference<TComponent> Entity::GetMutableComponent() const {
+	return registry->GetMutableComponent<TComponent>(*this);
+}
+
 /*
 * ********************************
 * System Template defintions
@@ -389,14 +1589,21 @@ TComponent& Entity::GetComponent() const {
 
 template <typename TSystem, typename ...TArgs>
 void Registry::AddSystem(TArgs&& ...args) {
-	std::shared_ptr<TSystem> newSystem = std::make_shared<TSystem>(std::forward<TArgs>(args)...);
-	systems.insert(std::make_pair(std::type_index(typeid(TSystem)), newSystem));
+	std::unique_ptr<TSystem> newSystem = std::make_unique<TSystem>(std::forward<TArgs>(args)...);
+	newSystem->registry = this;
+	if constexpr (std::is_copy_constructible_v<TSystem>) {
+		newSystem->copySystem = [](const System& system) -> System* { return new TSystem(static_cast<const TSystem&>(system)); };
+	}
+	ResolveSystemPools(*newSystem);
+	systems.insert(std::make_pair(std::type_index(typeid(TSystem)), std::move(newSystem)));
+	systemsPerSignature.clear();
 }
 
 template <typename TSystem>
 void Registry::RemoveSystem() {
 	auto system = systems.find(std::type_index(typeid(TSystem)));
 	systems.erase(system);
+	systemsPerSignature.clear();
 }
 
 template <typename TSystem>
@@ -407,5 +1614,5 @@ bool Registry::HasSystem() const {
 template <typename TSystem>
 TSystem& Registry::GetSystem() const {
 	auto system = systems.find(std::type_index(typeid(TSystem)));
-	return *(std::static_pointer_cast<TSystem>(system->second));
+	return *static_cast<TSystem*>(system->second.get());
 }
\ No newline at end of file
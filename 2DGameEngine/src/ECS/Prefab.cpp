@@ -0,0 +1,48 @@
+#include "Prefab.hpp"
+
+Prefab::Prefab(const Prefab& other) {
+	*this = other;
+}
+
+Prefab& Prefab::operator = (const Prefab& other) {
+	if (this == &other) {
+		return *this;
+	}
+	Clear();
+	for (const PrefabComponent& otherComponent : other.components) {
+		const ComponentInfo& info = IComponent::GetInfo(otherComponent.componentId);
+		void* component = ::operator new(info.size, std::align_val_t(info.alignment));
+		info.copyConstruct(component, otherComponent.component);
+		components.push_back({ otherComponent.componentId, component });
+	}
+	signature = other.signature;
+	tagId = other.tagId;
+	groupId = other.groupId;
+	return *this;
+}
+
+Prefab::~Prefab() {
+	Clear();
+}
+
+Prefab& Prefab::Tag(const std::string& tag) {
+	tagId = Registry::GetTagId(tag);
+	return *this;
+}
+
+Prefab& Prefab::Group(const std::string& group) {
+	groupId = Registry::GetGroupId(group);
+	return *this;
+}
+
+void Prefab::Clear() {
+	for (PrefabComponent& prefabComponent : components) {
+		const ComponentInfo& info = IComponent::GetInfo(prefabComponent.componentId);
+		info.destroy(prefabComponent.component);
+		::operator delete(prefabComponent.component, std::align_val_t(info.alignment));
+	}
+	components.clear();
+	signature.reset();
+	tagId = -1;
+	groupId = -1;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "ECS.hpp"
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ Prefab
+ Template for entities that are created over and over, e.g. projectiles. It holds
+ a copy of every component, the signature they make up and an optional tag and
+ group. Registry::Instantiate() copies all of it onto a new entity at once, the
+ components passed as overrides are used instead of the prefab's copies
+
+	Prefab bullet;
+	bullet.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4).Group("projectiles");
+	registry->Instantiate(bullet, TransformComponent(position, glm::vec2(1.0, 1.0), 0.0));
+*/
+class Prefab {
+public:
+	Prefab() = default;
+	Prefab(const Prefab& other);
+	Prefab& operator = (const Prefab& other);
+	~Prefab();
+
+	// add a component to the prefab, replaces the prefab's copy if it already has one
+	template <typename TComponent, typename ...TArgs> Prefab& AddComponent(TArgs&& ...args);
+	template <typename TComponent> bool HasComponent() const;
+
+	// a tag names a single entity, so a tagged prefab is meant to be instantiated once
+	Prefab& Tag(const std::string& tag);
+	Prefab& Group(const std::string& group);
+
+	const Signature& GetSignature() const { return signature; }
+	// interned ids, -1 if the prefab has no tag or group
+	int GetTagId() const { return tagId; }
+	int GetGroupId() const { return groupId; }
+
+private:
+	friend class Registry;
+
+	struct PrefabComponent {
+		int componentId;
+		void* component;
+	};
+
+	void Clear();
+
+	Signature signature;
+	std::vector<PrefabComponent> components;
+	int tagId = -1;
+	int groupId = -1;
+};
+
+template <typename TComponent, typename ...TArgs>
+Prefab& Prefab::AddComponent(TArgs&& ...args) {
+	static_assert(std::is_copy_constructible_v<TComponent>, "prefab components are copied onto every instance");
+
+	const int componentId = Component<TComponent>::GetId();
+	void* memory = ::operator new(sizeof(TComponent), std::align_val_t(alignof(TComponent)));
+	TComponent* component = new (memory) TComponent(std::forward<TArgs>(args)...);
+
+	for (PrefabComponent& prefabComponent : components) {
+		if (prefabComponent.componentId == componentId) {
+			TComponent* replaced = static_cast<TComponent*>(prefabComponent.component);
+			replaced->~TComponent();
+			::operator delete(replaced, std::align_val_t(alignof(TComponent)));
+			prefabComponent.component = component;
+			return *this;
+		}
+	}
+	components.push_back({ componentId, component });
+	signature.set(componentId);
+	return *this;
+}
+
+template <typename TComponent>
+bool Prefab::HasComponent() const {
+	return signature.test(Component<TComponent>::GetId());
+}
+
+/*
+* ********************************
+* Registry Prefab Template defintions
+* ********************************
+*/
+
+template <typename ...TOverrides>
+Entity Registry::Instantiate(const Prefab& prefab, TOverrides&& ...overrides) {
+	Entity entity = CreateEntity();
+	ApplyPrefab(entity, prefab, std::forward<TOverrides>(overrides)...);
+	return entity;
+}
+
+template <typename ...TOverrides>
+void Registry::ApplyPrefab(Entity entity, const Prefab& prefab, TOverrides&& ...overrides) {
+	Signature overridden;
+	(overridden.set(Component<std::decay_t<TOverrides>>::GetId()), ...);
+
+	const std::span<const Entity> entities(&entity, 1);
+	AddPrefabComponents(entities, prefab, overridden);
+	(SetPrefabOverride<std::decay_t<TOverrides>>(entity.GetId(), std::forward<TOverrides>(overrides)), ...);
+	FinishPrefabEntities(entities, prefab, overridden);
+}
+
+template <typename ...TOverrides>
+std::vector<Entity> Registry::InstantiateBatch(const Prefab& prefab, int count, std::span<const TOverrides> ...overrides) {
+	if (((overrides.size() < static_cast<size_t>(count)) || ...)) {
+		Logger::Err("Prefab can't be instantiated " + std::to_string(count) + " times, an override span is shorter than that");
+		return {};
+	}
+
+	std::vector<Entity> entities = CreateEntities(count);
+
+	Signature overridden;
+	(overridden.set(Component<TOverrides>::GetId()), ...);
+
+	AddPrefabComponents(entities, prefab, overridden);
+	([&] {
+		if (storageMode == StorageMode::Pools) {
+			// one pool lookup per override type, then plain inserts
+			Pool<TOverrides>* componentPool = GetOrCreatePool<TOverrides>();
+			for (int i = 0; i < count; i++) {
+				componentPool->Set(entities[i].GetId(), overrides[i], currentTick);
+			}
+		}
+		else {
+			for (int i = 0; i < count; i++) {
+				SetPrefabOverride<TOverrides>(entities[i].GetId(), overrides[i]);
+			}
+		}
+	}(), ...);
+	FinishPrefabEntities(entities, prefab, overridden);
+	return entities;
+}
+
+template <typename TComponent, typename TValue>
+void Registry::SetPrefabOverride(int entityId, TValue&& value) {
+	const int componentId = Component<TComponent>::GetId();
+	if (storageMode == StorageMode::Archetypes) {
+		// AddPrefabComponents() already moved the entity, a component it had before is replaced
+		void* component = archetypeStorage.GetComponent(entityId, componentId);
+		if (GetEntitySignature(entityId).test(componentId)) {
+			*static_cast<TComponent*>(component) = std::forward<TValue>(value);
+		}
+		else {
+			new (component) TComponent(std::forward<TValue>(value));
+		}
+	}
+	else {
+		GetOrCreatePool<TComponent>()->Set(entityId, std::forward<TValue>(value), currentTick);
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <glm/vec2.hpp>
+
+// how generic code reads and writes a reflected field
+enum class FieldType {
+	Bool,
+	Int,
+	Float,
+	Double,
+	Vec2,
+	String,
+	// any other plain value, copied as raw bytes
+	Bytes
+};
+
+struct FieldInfo {
+	const char* name;
+	size_t offset;
+	size_t size;
+	FieldType type;
+};
+
+template <typename TField>
+constexpr FieldType GetFieldType() {
+	static_assert(std::is_trivially_copyable_v<TField> || std::is_same_v<TField, std::string>, "reflected fields must be plain values or strings");
+	if constexpr (std::is_same_v<TField, bool>) {
+		return FieldType::Bool;
+	}
+	else if constexpr (std::is_same_v<TField, int>) {
+		return FieldType::Int;
+	}
+	else if constexpr (std::is_same_v<TField, float>) {
+		return FieldType::Float;
+	}
+	else if constexpr (std::is_same_v<TField, double>) {
+		return FieldType::Double;
+	}
+	else if constexpr (std::is_same_v<TField, glm::vec2>) {
+		return FieldType::Vec2;
+	}
+	else if constexpr (std::is_same_v<TField, std::string>) {
+		return FieldType::String;
+	}
+	else {
+		return FieldType::Bytes;
+	}
+}
+
+/*
+ ComponentMetadata
+ Name and fields of a component type, specialized once per component header with
+ REFLECT_COMPONENT. Types without a specialization still get an id, their name is
+ the compiler's type name and they have no fields
+*/
+template <typename T>
+struct ComponentMetadata {
+	static constexpr bool REFLECTED = false;
+};
+
+template <typename T>
+concept ReflectedComponent = ComponentMetadata<T>::REFLECTED;
+
+#define REFLECT_FIELD(TComponent, field) \
+	FieldInfo{ #field, offsetof(TComponent, field), sizeof(TComponent::field), GetFieldType<decltype(TComponent::field)>() }
+
+/*
+ e.g. REFLECT_COMPONENT(HealthComponent, REFLECT_FIELD(HealthComponent, healthPercentage))
+ at the end of the component header, outside of any namespace
+*/
+#define REFLECT_COMPONENT(TComponent, ...) \
+	template <> \
+	struct ComponentMetadata<TComponent> { \
+		static constexpr bool REFLECTED = true; \
+		static constexpr const char* NAME = #TComponent; \
+		static std::span<const FieldInfo> GetFields() { \
+			static const std::vector<FieldInfo> fields = { __VA_ARGS__ }; \
+			return fields; \
+		} \
+	};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ PoolStats
+ Memory use of one component pool. Bytes count reserved memory: the components,
+ the sparse pages, the packed entity ids and the change ticks. Fragmentation is
+ the share of reserved component slots that hold no component
+*/
+struct PoolStats {
+	int componentId = -1;
+	const char* name = nullptr;
+	int count = 0;
+	int capacity = 0;
+	size_t bytes = 0;
+	// number of times the component storage had to grow
+	int growthCount = 0;
+	float fragmentation = 0.0f;
+	// still shared with a clone, see Registry::Clone()
+	bool shared = false;
+};
+
+struct SystemStats {
+	std::string name;
+	int entityCount = 0;
+	size_t bytes = 0;
+};
+
+/*
+ RegistryStats
+ Snapshot of the memory and occupancy of a registry, see Registry::GetStats()
+*/
+struct RegistryStats {
+	std::uint32_t tick = 0;
+
+	int aliveEntityCount = 0;
+	// ids handed out so far, alive or free
+	int entityIdCount = 0;
+	int freeIdCount = 0;
+	// entities created or changed since the last Update(), they join systems in the next one
+	int pendingAddCount = 0;
+	int pendingKillCount = 0;
+	// commands recorded in the command buffers that the next Update() applies
+	int pendingCommandCount = 0;
+	int signatureCount = 0;
+
+	// per entity arrays, free ids, tags and groups
+	size_t entityBytes = 0;
+	size_t tagAndGroupBytes = 0;
+	size_t commandBufferBytes = 0;
+
+	std::vector<PoolStats> pools;
+	std::vector<SystemStats> systems;
+
+	// archetype storage only, fragmentation is the share of chunk rows that hold no entity
+	int archetypeCount = 0;
+	int chunkCount = 0;
+	size_t chunkBytes = 0;
+	float chunkFragmentation = 0.0f;
+
+	size_t GetTotalBytes() const;
+	/*
+	 Write the stats as lines of tab separated values, every line starts with the
+	 tick so the output of many frames can be appended to the same file:
+		tick registry alive ids free pendingAdds pendingKills pendingCommands signatures totalBytes
+		tick pool name count capacity bytes growths fragmentation shared
+		tick system name entities bytes
+		tick archetypes archetypes chunks bytes fragmentation
+	*/
+	void Write(std::ostream& stream) const;
+};
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define SIGNATURE_SSE2
+#include <immintrin.h>
+#endif
+
+// number of component types a registry can hold, define ECS_MAX_COMPONENTS to raise it
+#ifndef ECS_MAX_COMPONENTS
+#define ECS_MAX_COMPONENTS 256
+#endif
+
+const unsigned int MAX_COMPONENTS = ECS_MAX_COMPONENTS;
+
+static_assert(MAX_COMPONENTS > 0 && MAX_COMPONENTS % 64 == 0, "ECS_MAX_COMPONENTS must be a multiple of 64");
+
+/*
+ Signature
+ a bitset (1s and 0s) to keep track of which components an enity has,
+ and also helps keep track of which entities a given sytem is interested in.
+ The bits are stored in 64 bit words that the matching functions compare
+ two or four at a time with vector instructions
+*/
+class Signature {
+public:
+	static constexpr size_t WORD_COUNT = MAX_COMPONENTS / 64;
+
+	Signature() = default;
+
+	bool test(size_t bit) const {
+		assert(bit < MAX_COMPONENTS);
+		return (words[bit / 64] >> (bit % 64)) & 1;
+	}
+
+	Signature& set(size_t bit, bool value = true) {
+		assert(bit < MAX_COMPONENTS);
+		const std::uint64_t mask = std::uint64_t(1) << (bit % 64);
+		words[bit / 64] = value ? words[bit / 64] | mask : words[bit / 64] & ~mask;
+		return *this;
+	}
+
+	Signature& reset() {
+		words.fill(0);
+		return *this;
+	}
+
+	Signature& reset(size_t bit) {
+		return set(bit, false);
+	}
+
+	bool any() const {
+		std::uint64_t bits = 0;
+		for (std::uint64_t word : words) {
+			bits |= word;
+		}
+		return bits != 0;
+	}
+
+	bool none() const {
+		return !any();
+	}
+
+	static constexpr size_t size() {
+		return MAX_COMPONENTS;
+	}
+
+	// true if every bit of other is also set here, same as (*this & other) == other without the temporary
+	bool Contains(const Signature& other) const {
+		size_t word = 0;
+		bool contains = true;
+#if defined(__AVX2__)
+		__m256i missing = _mm256_setzero_si256();
+		for (; word + 4 <= WORD_COUNT; word += 4) {
+			const __m256i bits = _mm256_load_si256(reinterpret_cast<const __m256i*>(&words[word]));
+			const __m256i otherBits = _mm256_load_si256(reinterpret_cast<const __m256i*>(&other.words[word]));
+			missing = _mm256_or_si256(missing, _mm256_andnot_si256(bits, otherBits));
+		}
+		contains = _mm256_testz_si256(missing, missing);
+#elif defined(SIGNATURE_SSE2)
+		__m128i missing = _mm_setzero_si128();
+		for (; word + 2 <= WORD_COUNT; word += 2) {
+			const __m128i bits = _mm_load_si128(reinterpret_cast<const __m128i*>(&words[word]));
+			const __m128i otherBits = _mm_load_si128(reinterpret_cast<const __m128i*>(&other.words[word]));
+			missing = _mm_or_si128(missing, _mm_andnot_si128(bits, otherBits));
+		}
+		// sse2 has no test instruction, compare the bytes with zero instead
+		contains = _mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128())) == 0xFFFF;
+#endif
+		// words left over by the vector loop, or all of them without vector instructions
+		for (; word < WORD_COUNT; word++) {
+			contains = contains && (other.words[word] & ~words[word]) == 0;
+		}
+		return contains;
+	}
+
+	// true if at least one bit is set in both signatures, same as (*this & other).any()
+	bool Intersects(const Signature& other) const {
+		std::uint64_t shared = 0;
+		for (size_t word = 0; word < WORD_COUNT; word++) {
+			shared |= words[word] & other.words[word];
+		}
+		return shared != 0;
+	}
+
+	Signature& operator &= (const Signature& other) {
+		for (size_t word = 0; word < WORD_COUNT; word++) {
+			words[word] &= other.words[word];
+		}
+		return *this;
+	}
+
+	Signature& operator |= (const Signature& other) {
+		for (size_t word = 0; word < WORD_COUNT; word++) {
+			words[word] |= other.words[word];
+		}
+		return *this;
+	}
+
+	Signature operator & (const Signature& other) const { return Signature(*this) &= other; }
+	Signature operator | (const Signature& other) const { return Signature(*this) |= other; }
+
+	Signature operator ~ () const {
+		Signature inverted;
+		for (size_t word = 0; word < WORD_COUNT; word++) {
+			inverted.words[word] = ~words[word];
+		}
+		return inverted;
+	}
+
+	bool operator == (const Signature& other) const { return words == other.words; }
+	bool operator != (const Signature& other) const { return words != other.words; }
+
+	size_t Hash() const {
+		size_t hash = 0;
+		for (std::uint64_t word : words) {
+			hash = (hash ^ std::hash<std::uint64_t>()(word)) * 0x100000001B3;
+		}
+		return hash;
+	}
+
+private:
+	// aligned so the vector loads in Contains() can't fault
+	alignas(32) std::array<std::uint64_t, WORD_COUNT> words{};
+};
+
+namespace std {
+	template <>
+	struct hash<Signature> {
+		size_t operator()(const Signature& signature) const {
+			return signature.Hash();
+		}
+	};
+}
+
+/*
+ SignatureTable
+ Interns every distinct signature to a small id, so an entity stores one int
+ instead of a full signature and comparing two signatures compares two ints.
+ Adding or removing a component follows a cached edge to the next id, the full
+ signature is only hashed the first time an edge is taken. Ids are never freed,
+ the number of distinct signatures stays close to the number of archetypes
+*/
+class SignatureTable {
+public:
+	// id of the empty signature
+	static constexpr int EMPTY = 0;
+
+	SignatureTable() {
+		GetId(Signature());
+	}
+
+	// references stay valid while signatures are added
+	const Signature& Get(int signatureId) const {
+		return signatures[signatureId];
+	}
+
+	int GetCount() const {
+		return static_cast<int>(signatures.size());
+	}
+
+	int GetId(const Signature& signature) {
+		auto interned = idPerSignature.find(signature);
+		if (interned != idPerSignature.end()) {
+			return interned->second;
+		}
+		const int signatureId = static_cast<int>(signatures.size());
+		signatures.push_back(signature);
+		idPerSignature.emplace(signature, signatureId);
+		return signatureId;
+	}
+
+	// id of the signature with the component added, or removed if value is false
+	int With(int signatureId, int componentId, bool value = true) {
+		if (signatures[signatureId].test(componentId) == value) {
+			return signatureId;
+		}
+		const std::uint64_t edge = (static_cast<std::uint64_t>(signatureId) << 32) | static_cast<std::uint32_t>(componentId);
+		auto cached = edges.find(edge);
+		if (cached != edges.end()) {
+			return cached->second;
+		}
+		Signature signature = signatures[signatureId];
+		const int targetId = GetId(signature.set(componentId, value));
+		edges.emplace(edge, targetId);
+		return targetId;
+	}
+
+	int Without(int signatureId, int componentId) {
+		return With(signatureId, componentId, false);
+	}
+
+private:
+	std::deque<Signature> signatures;
+	std::unordered_map<Signature, int> idPerSignature;
+	// (signature id << 32 | component id) -> id with that component flipped
+	std::unordered_map<std::uint64_t, int> edges;
+};
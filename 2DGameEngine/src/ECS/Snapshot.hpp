@@ -0,0 +1,263 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "Reflection.hpp"
+
+/*
+ Snapshot format, see Registry::SaveSnapshot()
+
+	SnapshotHeader
+	entity generations        uint32[entityCount]
+	free ids                  int32[freeIdCount]
+	tags                      { int32 entityId, uint32 string }[tagCount]
+	groups                    { int32 entityId, uint32 string }[groupCount]
+	poolCount x
+		SnapshotPoolHeader
+		entity ids            int32[count]
+		components            written by the pool, arrays for plain types
+	string table              uint32 count, then { uint32 length, chars } per string
+
+ Every array starts on a 64 byte boundary of the snapshot, so a snapshot read into
+ an aligned buffer or mapped from a file can be copied back with one memcpy per
+ array. Pools are keyed by the component type name because component ids depend
+ on the order types are first used, strings are written once to the string table
+ and referenced by index
+*/
+struct SnapshotHeader {
+	static constexpr std::uint32_t MAGIC = 0x53453244; // "D2ES"
+	// 2: pools of reflected components are keyed by their REFLECT_COMPONENT name
+	static constexpr std::uint32_t VERSION = 2;
+
+	std::uint32_t magic = MAGIC;
+	std::uint32_t version = VERSION;
+	std::uint32_t entityCount = 0;
+	std::uint32_t freeIdCount = 0;
+	std::uint32_t tagCount = 0;
+	std::uint32_t groupCount = 0;
+	std::uint32_t poolCount = 0;
+	std::uint32_t reserved = 0;
+	std::uint64_t stringTableOffset = 0;
+	std::uint64_t size = 0;
+};
+
+struct SnapshotPoolHeader {
+	// index of the component type name in the string table
+	std::uint32_t name = 0;
+	// sizeof the component, a mismatch means the type changed since the snapshot was written
+	std::uint32_t componentSize = 0;
+	std::uint32_t count = 0;
+	std::uint32_t reserved = 0;
+	// snapshot offset right after the components, lets a loader skip pools it doesn't know
+	std::uint64_t end = 0;
+};
+
+struct SnapshotEntityString {
+	std::int32_t entityId;
+	std::uint32_t string;
+};
+
+class SnapshotWriter {
+public:
+	static constexpr size_t ALIGNMENT = 64;
+
+	SnapshotWriter(size_t expectedSize = 0) {
+		bytes.reserve(expectedSize);
+	}
+
+	template <typename T>
+	void Write(const T& value) {
+		static_assert(std::is_trivially_copyable_v<T>, "only plain values can be written as bytes");
+		WriteBytes(&value, sizeof(T));
+	}
+
+	// an array on a 64 byte boundary
+	template <typename T>
+	void WriteArray(const T* values, size_t count) {
+		static_assert(std::is_trivially_copyable_v<T>, "only plain values can be written as bytes");
+		Align();
+		WriteBytes(values, count * sizeof(T));
+	}
+
+	void WriteBytes(const void* data, size_t size) {
+		const size_t offset = bytes.size();
+		bytes.resize(offset + size);
+		if (size > 0) {
+			std::memcpy(bytes.data() + offset, data, size);
+		}
+	}
+
+	// writes the index of the string in the string table
+	void WriteString(const std::string& string) {
+		Write(InternString(string));
+	}
+
+	std::uint32_t InternString(const std::string& string) {
+		auto [entry, inserted] = stringIndices.try_emplace(string, static_cast<std::uint32_t>(strings.size()));
+		if (inserted) {
+			strings.push_back(&entry->first);
+		}
+		return entry->second;
+	}
+
+	// pad with zeros up to the next 64 byte boundary
+	void Align() {
+		bytes.resize((bytes.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+	}
+
+	size_t GetOffset() const { return bytes.size(); }
+	std::byte* GetData() { return bytes.data(); }
+	const std::vector<const std::string*>& GetStrings() const { return strings; }
+
+	// hand over the written bytes
+	std::vector<std::byte> Release() { return std::move(bytes); }
+
+private:
+	std::vector<std::byte> bytes;
+	// node based so the string pointers stay valid while more strings are interned
+	std::unordered_map<std::string, std::uint32_t> stringIndices;
+	std::vector<const std::string*> strings;
+};
+
+class SnapshotReader {
+public:
+	SnapshotReader(std::span<const std::byte> bytes) : bytes(bytes) {}
+
+	// false once a read went past the end, every later read returns zeros
+	bool IsValid() const { return valid; }
+
+	template <typename T>
+	T Read() {
+		static_assert(std::is_trivially_copyable_v<T>, "only plain values can be read as bytes");
+		T value{};
+		ReadBytes(&value, sizeof(T));
+		return value;
+	}
+
+	template <typename T>
+	void ReadArray(T* values, size_t count) {
+		static_assert(std::is_trivially_copyable_v<T>, "only plain values can be read as bytes");
+		Align();
+		ReadBytes(values, count * sizeof(T));
+	}
+
+	void ReadBytes(void* data, size_t size) {
+		if (!Require(size)) {
+			std::memset(data, 0, size);
+			return;
+		}
+		if (size > 0) {
+			std::memcpy(data, bytes.data() + offset, size);
+		}
+		offset += size;
+	}
+
+	const std::string& ReadString() {
+		return GetString(Read<std::uint32_t>());
+	}
+
+	// string of the string table with the given index
+	const std::string& GetString(std::uint32_t index) {
+		if (index >= strings.size()) {
+			valid = false;
+			return emptyString;
+		}
+		return strings[index];
+	}
+
+	// read the string table at the given offset, strings are looked up by index afterwards
+	void ReadStringTable(size_t tableOffset) {
+		const size_t previousOffset = offset;
+		offset = tableOffset;
+		const std::uint32_t count = Read<std::uint32_t>();
+		strings.clear();
+		if (count > bytes.size()) {
+			valid = false;
+		}
+		strings.reserve(valid ? count : 0);
+		for (std::uint32_t i = 0; i < count && valid; i++) {
+			const std::uint32_t length = Read<std::uint32_t>();
+			if (!Require(length)) {
+				break;
+			}
+			strings.emplace_back(reinterpret_cast<const char*>(bytes.data() + offset), length);
+			offset += length;
+		}
+		offset = previousOffset;
+	}
+
+	void Align() {
+		offset = (offset + SnapshotWriter::ALIGNMENT - 1) / SnapshotWriter::ALIGNMENT * SnapshotWriter::ALIGNMENT;
+	}
+
+	size_t GetOffset() const { return offset; }
+
+	void Seek(size_t newOffset) {
+		offset = newOffset;
+		if (offset > bytes.size()) {
+			valid = false;
+		}
+	}
+
+private:
+	bool Require(size_t size) {
+		if (!valid || offset > bytes.size() || bytes.size() - offset < size) {
+			valid = false;
+			return false;
+		}
+		return true;
+	}
+
+	std::span<const std::byte> bytes;
+	size_t offset = 0;
+	bool valid = true;
+	std::vector<std::string> strings;
+	std::string emptyString;
+};
+
+/*
+ Components that aren't plain values, e.g. because they hold strings, are written
+ field by field if they are reflected, see Reflection.hpp, or by their own members:
+	void Save(SnapshotWriter& writer) const;
+	void Load(SnapshotReader& reader);
+*/
+template <typename T>
+concept SelfSerializingComponent = requires(const T& component, T& loadedComponent, SnapshotWriter& writer, SnapshotReader& reader) {
+	component.Save(writer);
+	loadedComponent.Load(reader);
+};
+
+// components that can be written to a snapshot, they are default constructed before they are loaded
+template <typename T>
+constexpr bool IsSnapshotSerializable = std::is_default_constructible_v<T> && (SelfSerializingComponent<T> || std::is_trivially_copyable_v<T> || ReflectedComponent<T>);
+
+// write the fields of a reflected component in order, strings go to the string table
+inline void SaveFields(SnapshotWriter& writer, const void* component, std::span<const FieldInfo> fields) {
+	const std::byte* bytes = static_cast<const std::byte*>(component);
+	for (const FieldInfo& field : fields) {
+		if (field.type == FieldType::String) {
+			writer.WriteString(*reinterpret_cast<const std::string*>(bytes + field.offset));
+		}
+		else {
+			writer.WriteBytes(bytes + field.offset, field.size);
+		}
+	}
+}
+
+inline void LoadFields(SnapshotReader& reader, void* component, std::span<const FieldInfo> fields) {
+	std::byte* bytes = static_cast<std::byte*>(component);
+	for (const FieldInfo& field : fields) {
+		if (field.type == FieldType::String) {
+			*reinterpret_cast<std::string*>(bytes + field.offset) = reader.ReadString();
+		}
+		else {
+			reader.ReadBytes(bytes + field.offset, field.size);
+		}
+	}
+}
@@ -0,0 +1,277 @@
+#pragma once
+
+#include "ECS.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+/*
+ AlignedArray
+ Growable array of plain values whose storage starts on a 64 byte boundary and
+ whose capacity is a whole number of 64 byte blocks, so loops over it can use
+ aligned vector loads
+*/
+template <typename T>
+class AlignedArray {
+	static_assert(std::is_trivially_copyable_v<T>, "AlignedArray only holds plain values");
+
+public:
+	static constexpr size_t ALIGNMENT = 64;
+
+	AlignedArray() = default;
+
+	AlignedArray(const AlignedArray& other) {
+		*this = other;
+	}
+
+	AlignedArray& operator = (const AlignedArray& other) {
+		if (this != &other) {
+			size = 0;
+			Reserve(other.size);
+			if (other.size > 0) {
+				std::memcpy(data, other.data, other.size * sizeof(T));
+			}
+			size = other.size;
+		}
+		return *this;
+	}
+
+	~AlignedArray() {
+		if (data) {
+			::operator delete(data, std::align_val_t(ALIGNMENT));
+		}
+	}
+
+	void Reserve(int newCapacity) {
+		if (newCapacity <= capacity) {
+			return;
+		}
+		constexpr int valuesPerBlock = static_cast<int>(ALIGNMENT / sizeof(T));
+		newCapacity = (newCapacity + valuesPerBlock - 1) / valuesPerBlock * valuesPerBlock;
+
+		T* newData = static_cast<T*>(::operator new(newCapacity * sizeof(T), std::align_val_t(ALIGNMENT)));
+		if (data) {
+			std::memcpy(newData, data, size * sizeof(T));
+			::operator delete(data, std::align_val_t(ALIGNMENT));
+		}
+		data = newData;
+		capacity = newCapacity;
+	}
+
+	void PushBack(T value) {
+		if (size == capacity) {
+			Reserve(capacity == 0 ? 16 : capacity * 2);
+		}
+		data[size++] = value;
+	}
+
+	// new values are left uninitialized
+	void Resize(int newSize) {
+		Reserve(newSize);
+		size = newSize;
+	}
+
+	void PopBack() { size--; }
+	void Clear() { size = 0; }
+	void Move(int from, int to) { data[to] = data[from]; }
+	void Swap(int a, int b) { std::swap(data[a], data[b]); }
+
+	int Size() const { return size; }
+	int Capacity() const { return capacity; }
+	T* Data() { return data; }
+	const T* Data() const { return data; }
+	T& operator [] (int index) { return data[index]; }
+	const T& operator [] (int index) const { return data[index]; }
+
+private:
+	T* data = nullptr;
+	int size = 0;
+	int capacity = 0;
+};
+
+/*
+ Vec2Reference
+ Stands in for a glm::vec2 whose x and y live in two separate arrays. Reading it
+ converts to a glm::vec2, assigning to it writes both arrays
+*/
+struct Vec2Reference {
+	float& x;
+	float& y;
+
+	Vec2Reference(float& x, float& y) : x(x), y(y) {}
+	Vec2Reference(glm::vec2& vector) : x(vector.x), y(vector.y) {}
+	Vec2Reference(const Vec2Reference& other) = default;
+
+	operator glm::vec2() const { return glm::vec2(x, y); }
+
+	Vec2Reference& operator = (const glm::vec2& vector) {
+		x = vector.x;
+		y = vector.y;
+		return *this;
+	}
+
+	// assigns the value, like assigning one glm::vec2& to another
+	Vec2Reference& operator = (const Vec2Reference& other) {
+		return *this = glm::vec2(other);
+	}
+
+	Vec2Reference& operator += (const glm::vec2& vector) {
+		x += vector.x;
+		y += vector.y;
+		return *this;
+	}
+
+	Vec2Reference& operator -= (const glm::vec2& vector) {
+		x -= vector.x;
+		y -= vector.y;
+		return *this;
+	}
+};
+
+/*
+ SoAPool
+ Pool that keeps every field of a component in its own packed array, in the same
+ order as the entity ids of the sparse set, so integration loops read and write
+ contiguous floats. TColumns holds the arrays and converts between them and the
+ component:
+	ForEachColumn(func) calls func(array) for every AlignedArray
+	Store(index, component) / Load(index) write and read a whole component
+	GetReference(index) returns a proxy whose fields refer to the arrays
+ Get() returns the proxy for write access and a copy of the component for read access
+*/
+template <typename TComponent, typename TColumns>
+class SoAPool : public IPool {
+public:
+	using Reference = typename TColumns::Reference;
+	using ConstReference = TComponent;
+	static constexpr bool STORES_OBJECTS = false;
+
+	SoAPool(int capacity = 100) {
+		Reserve(capacity);
+	}
+
+	virtual ~SoAPool() = default;
+
+	void Reserve(int capacity) {
+		columns.ForEachColumn([capacity](auto& column) { column.Reserve(capacity); });
+		addedTicks.reserve(capacity);
+		changedTicks.reserve(capacity);
+		ReserveSet(capacity);
+	}
+
+	void Clear() override {
+		columns.ForEachColumn([](auto& column) { column.Clear(); });
+		addedTicks.clear();
+		changedTicks.clear();
+		ClearSet();
+	}
+
+	// the registry casts pools to Pool<TComponent>, so the copy must be one too
+	IPool* Clone() const override {
+		return new Pool<TComponent>(static_cast<const Pool<TComponent>&>(*this));
+	}
+
+	void AddCopies(std::span<const Entity> entities, const void* component, std::uint32_t tick) override {
+		const TComponent& object = *static_cast<const TComponent*>(component);
+		for (Entity entity : entities) {
+			Set(entity.GetId(), object, tick);
+		}
+	}
+
+	// one array per field, the columns only have a non const ForEachColumn() but are just read here
+	void Save(SnapshotWriter& writer) const override {
+		const_cast<TColumns&>(columns).ForEachColumn([&writer](const auto& column) { writer.WriteArray(column.Data(), column.Size()); });
+	}
+
+	void Load(SnapshotReader& reader, std::span<const int> entityIds, std::uint32_t tick) override {
+		LoadEntityIds(entityIds, tick);
+		const int count = static_cast<int>(entityIds.size());
+		columns.ForEachColumn([&reader, count](auto& column) {
+			column.Resize(count);
+			reader.ReadArray(column.Data(), count);
+		});
+	}
+
+	// tick = registry tick the component is stamped with, a replaced component counts as changed
+	void Set(int entityId, const TComponent& object, std::uint32_t tick = 0) {
+		if (Contains(entityId)) {
+			const int index = IndexOf(entityId);
+			columns.Store(index, object);
+			changedTicks[index] = tick;
+		}
+		else {
+			const int index = Insert(entityId);
+			if (GetCapacity() == index) {
+				growthCount++;
+			}
+			columns.ForEachColumn([](auto& column) { column.PushBack({}); });
+			columns.Store(index, object);
+			addedTicks.push_back(tick);
+			changedTicks.push_back(tick);
+		}
+	}
+
+	void Remove(int entityId) {
+		// move last element to the deleted position to keep the arrays packed
+		const int indexOfRemoved = Erase(entityId);
+		const int lastIndex = static_cast<int>(changedTicks.size()) - 1;
+		if (indexOfRemoved != lastIndex) {
+			columns.ForEachColumn([indexOfRemoved, lastIndex](auto& column) { column.Move(lastIndex, indexOfRemoved); });
+			addedTicks[indexOfRemoved] = addedTicks.back();
+			changedTicks[indexOfRemoved] = changedTicks.back();
+		}
+		columns.ForEachColumn([](auto& column) { column.PopBack(); });
+		addedTicks.pop_back();
+		changedTicks.pop_back();
+	}
+
+	void RemoveEntityFromPool(int entityId) override {
+		if (Contains(entityId)) {
+			Remove(entityId);
+		}
+	}
+
+	Reference Get(int entityId) {
+		return columns.GetReference(IndexOf(entityId));
+	}
+
+	TComponent Get(int entityId) const {
+		return columns.Load(IndexOf(entityId));
+	}
+
+	Reference operator [] (unsigned int index) {
+		return columns.GetReference(index);
+	}
+
+	// field arrays in packed order, column[i] belongs to GetEntityIds()[i]
+	TColumns& GetColumns() {
+		return columns;
+	}
+
+	// every column grows on its own, the pool is full once the smallest one is
+	int GetCapacity() const override {
+		int capacity = INT_MAX;
+		const_cast<TColumns&>(columns).ForEachColumn([&capacity](const auto& column) { capacity = std::min(capacity, column.Capacity()); });
+		return capacity;
+	}
+
+	size_t GetComponentBytes() const override {
+		size_t bytes = 0;
+		const_cast<TColumns&>(columns).ForEachColumn([&bytes](const auto& column) { bytes += column.Capacity() * sizeof(*column.Data()); });
+		return bytes;
+	}
+
+protected:
+	void SwapSlots(int a, int b) override {
+		columns.ForEachColumn([a, b](auto& column) { column.Swap(a, b); });
+		std::swap(addedTicks[a], addedTicks[b]);
+		std::swap(changedTicks[a], changedTicks[b]);
+		SwapEntries(a, b);
+	}
+
+private:
+	TColumns columns;
+};
@@ -0,0 +1,155 @@
+#include "SystemScheduler.hpp"
+#include "CommandBuffer.hpp"
+#include <algorithm>
+#include <chrono>
+
+SystemScheduler::SystemScheduler(JobSystem& jobSystem) : jobSystem(jobSystem) {
+}
+
+void SystemScheduler::Clear() {
+	tasks.clear();
+	stageTasks.clear();
+	stageTimings = {};
+	pendingDependencies.reset();
+}
+
+void SystemScheduler::SetEnabled(int taskId, bool enabled) {
+	Task& task = tasks[taskId];
+	if (enabled && !task.enabled) {
+		// the time the task was off isn't handed to its first run
+		task.elapsed = 0.0;
+		task.tickTimer = 0.0;
+	}
+	task.enabled = enabled;
+}
+
+bool SystemScheduler::IsEnabled(int taskId) const {
+	return tasks[taskId].enabled;
+}
+
+void SystemScheduler::SetTickRate(int taskId, double hz) {
+	tasks[taskId].tickInterval = hz > 0.0 ? 1.0 / hz : 0.0;
+}
+
+void SystemScheduler::SetTimeSlice(int taskId, int frameInterval, int frameOffset) {
+	if (frameInterval < 1) {
+		Logger::Err("Time slice of system task " + std::to_string(taskId) + " must be at least one frame");
+		return;
+	}
+	tasks[taskId].frameInterval = frameInterval;
+	tasks[taskId].frameOffset = frameOffset % frameInterval;
+}
+
+void SystemScheduler::BeginFrame(double deltaTime) {
+	frame++;
+	for (Task& task : tasks) {
+		task.due = false;
+		if (!task.enabled) {
+			continue;
+		}
+		task.elapsed += deltaTime;
+		task.tickTimer += deltaTime;
+		task.due = frame % task.frameInterval == static_cast<std::uint64_t>(task.frameOffset) && task.tickTimer >= task.tickInterval;
+		if (task.due && task.tickInterval > 0.0) {
+			// after a long frame run once instead of catching up on every missed tick
+			task.tickTimer = std::min(task.tickTimer - task.tickInterval, task.tickInterval);
+		}
+	}
+}
+
+void SystemScheduler::BuildGraph() {
+	for (int taskIndex : stageTasks) {
+		tasks[taskIndex].dependents.clear();
+		tasks[taskIndex].dependencyCount = 0;
+	}
+
+	// a task only depends on earlier tasks, so conflicting systems keep their registration order
+	for (int i = 0; i < stageTasks.size(); i++) {
+		for (int j = 0; j < i; j++) {
+			Task& task = tasks[stageTasks[i]];
+			Task& earlierTask = tasks[stageTasks[j]];
+			if (task.system->ConflictsWith(*earlierTask.system)) {
+				earlierTask.dependents.push_back(stageTasks[i]);
+				task.dependencyCount++;
+			}
+		}
+	}
+}
+
+void SystemScheduler::Run(SystemStage stage) {
+	const auto start = std::chrono::steady_clock::now();
+
+	stageTasks.clear();
+	for (int i = 0; i < tasks.size(); i++) {
+		if (tasks[i].due && tasks[i].stage == stage) {
+			stageTasks.push_back(i);
+		}
+	}
+
+	// pools shared with a registry clone are copied here, before any system of the stage can write them
+	for (int taskIndex : stageTasks) {
+		System& system = *tasks[taskIndex].system;
+		if (system.registry) {
+			system.registry->UnshareWrittenPools(system);
+		}
+	}
+
+	if (stage == SystemStage::PreUpdate || stage == SystemStage::Render) {
+		for (int taskIndex : stageTasks) {
+			tasks[taskIndex].dependents.clear();
+			RunTask(taskIndex);
+		}
+	}
+	else {
+		BuildGraph();
+		for (int taskIndex : stageTasks) {
+			pendingDependencies[taskIndex].store(tasks[taskIndex].dependencyCount, std::memory_order_relaxed);
+		}
+		for (int taskIndex : stageTasks) {
+			if (tasks[taskIndex].dependencyCount == 0) {
+				SubmitTask(taskIndex);
+			}
+		}
+		jobSystem.Wait(counter);
+	}
+
+	StageTiming& timing = stageTimings[static_cast<int>(stage)];
+	timing.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	timing.taskCount = static_cast<int>(stageTasks.size());
+}
+
+double SystemScheduler::GetStageMilliseconds(SystemStage stage) const {
+	return stageTimings[static_cast<int>(stage)].milliseconds;
+}
+
+double SystemScheduler::GetTaskMilliseconds(int taskId) const {
+	return tasks[taskId].milliseconds;
+}
+
+int SystemScheduler::GetStageTaskCount(SystemStage stage) const {
+	return stageTimings[static_cast<int>(stage)].taskCount;
+}
+
+void SystemScheduler::SubmitTask(int taskIndex) {
+	jobSystem.Submit([this, taskIndex]() { RunTask(taskIndex); }, counter);
+}
+
+void SystemScheduler::RunTask(int taskIndex) {
+	Task& task = tasks[taskIndex];
+	// commands the system records are applied in stage and registration order, whichever thread
+	// runs it, also when this thread runs other jobs while the task waits
+	const std::uint64_t taskKey = (static_cast<std::uint64_t>(task.stage) + 1) << TASK_INDEX_BITS | static_cast<std::uint64_t>(taskIndex);
+	JobOrder::Scope scope(taskKey << JobOrder::ROOT_FREE_BITS, JobOrder::ROOT_FREE_BITS);
+
+	const auto start = std::chrono::steady_clock::now();
+	task.function(task.elapsed);
+	task.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	task.elapsed = 0.0;
+
+	// the last dependency to finish releases the dependent task
+	for (int dependent : task.dependents) {
+		if (pendingDependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			SubmitTask(dependent);
+		}
+	}
+}
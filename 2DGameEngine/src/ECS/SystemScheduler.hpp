@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "ECS.hpp"
+#include "../JobSystem/JobSystem.hpp"
+
+/*
+ SystemStage
+ Stages run one after another in this order, every stage finishes before the next
+ one starts. PreUpdate and Render run their systems on the calling thread in
+ registration order, e.g. for event subscriptions and the SDL renderer. Update and
+ PostUpdate run their systems as jobs
+*/
+enum class SystemStage {
+	PreUpdate,
+	Update,
+	PostUpdate,
+	Render
+};
+
+const int SYSTEM_STAGE_COUNT = 4;
+
+/*
+ SystemScheduler
+ Pipeline of system tasks kept in one flat vector, running a stage never looks a
+ system up by type. In the job stages the scheduler builds a dependency graph from
+ the component access the systems declared: a system waits for the earlier
+ registered systems of its stage it conflicts with, systems that don't conflict
+ run at the same time. The result is the same as running the systems one after
+ another in registration order.
+ Tasks can be disabled, run at a fixed rate, or sliced to run on one frame out of
+ several so systems with the same interval can be spread over different frames
+*/
+class SystemScheduler {
+public:
+	// the stage and task index make the JobOrder key above the root scope bits
+	static constexpr int TASK_INDEX_BITS = 13;
+	static constexpr int MAX_TASKS = 1 << TASK_INDEX_BITS;
+
+	SystemScheduler(JobSystem& jobSystem);
+
+	SystemScheduler(const SystemScheduler&) = delete;
+	SystemScheduler& operator = (const SystemScheduler&) = delete;
+
+	/*
+	 Register the function that updates a system, called as func(system, elapsed) or
+	 func(system) when the task is due. elapsed is the time in seconds since the task
+	 last ran, which is longer than a frame for tasks with a tick rate or time slice
+	 @return task id, -1 if there are already MAX_TASKS tasks
+	*/
+	template <typename TSystem, typename TFunc> int AddTask(TSystem& system, TFunc func, SystemStage stage = SystemStage::Update);
+	void Clear();
+
+	void SetEnabled(int taskId, bool enabled);
+	bool IsEnabled(int taskId) const;
+	// run the task at most hz times a second, 0 runs it every frame
+	void SetTickRate(int taskId, double hz);
+	// run the task on the frames where frame % frameInterval == frameOffset, 1 runs it every frame
+	void SetTimeSlice(int taskId, int frameInterval, int frameOffset = 0);
+
+	// advance the frame clock and work out which tasks are due this frame, call once before the stages
+	void BeginFrame(double deltaTime);
+	// run the due tasks of a stage and wait until all of them are done
+	void Run(SystemStage stage);
+
+	// wall time of the last Run() of the stage and of the last run of a task, in milliseconds
+	double GetStageMilliseconds(SystemStage stage) const;
+	double GetTaskMilliseconds(int taskId) const;
+	// number of tasks the last Run() of the stage ran
+	int GetStageTaskCount(SystemStage stage) const;
+
+private:
+	struct Task {
+		System* system;
+		std::function<void(double)> function;
+		SystemStage stage;
+		bool enabled = true;
+		// seconds between runs, 0 for every frame
+		double tickInterval = 0.0;
+		int frameInterval = 1;
+		int frameOffset = 0;
+		// seconds since the task last ran
+		double elapsed = 0.0;
+		// time toward the next tick, the remainder carries over so the rate holds on average
+		double tickTimer = 0.0;
+		// set by BeginFrame()
+		bool due = false;
+		double milliseconds = 0.0;
+		// tasks that must wait for this one
+		std::vector<int> dependents;
+		int dependencyCount = 0;
+	};
+
+	struct StageTiming {
+		double milliseconds = 0.0;
+		int taskCount = 0;
+	};
+
+	// build the graph between the due tasks of the stage, collected in stageTasks
+	void BuildGraph();
+	void SubmitTask(int taskIndex);
+	void RunTask(int taskIndex);
+
+	JobSystem& jobSystem;
+	std::vector<Task> tasks;
+	// due tasks of the stage being run, in registration order
+	std::vector<int> stageTasks;
+	std::array<StageTiming, SYSTEM_STAGE_COUNT> stageTimings;
+	std::uint64_t frame = 0;
+	// dependencies each task is still waiting for during Run()
+	std::unique_ptr<std::atomic<int>[]> pendingDependencies;
+	JobCounter counter;
+};
+
+template <typename TSystem, typename TFunc>
+int SystemScheduler::AddTask(TSystem& system, TFunc func, SystemStage stage) {
+	if (tasks.size() >= MAX_TASKS) {
+		Logger::Err("System scheduler can't hold more than " + std::to_string(MAX_TASKS) + " tasks");
+		return -1;
+	}
+	Task task;
+	task.system = &system;
+	task.stage = stage;
+	if constexpr (std::is_invocable_v<TFunc&, TSystem&, double>) {
+		task.function = [&system, func](double elapsed) mutable { func(system, elapsed); };
+	}
+	else {
+		task.function = [&system, func](double) mutable { func(system); };
+	}
+	tasks.push_back(std::move(task));
+	pendingDependencies = std::make_unique<std::atomic<int>[]>(tasks.size());
+	return static_cast<int>(tasks.size()) - 1;
+}
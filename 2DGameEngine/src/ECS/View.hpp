@@ -0,0 +1,241 @@
+#pragma once
+
+#include "ECS.hpp"
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/*
+ View filters
+ Exclude<T...> skips entities that have any of the components,
+ Optional<T> yields a T* that is nullptr when the entity doesn't have the component
+*/
+template <typename ...TComponents>
+struct Exclude {};
+
+template <typename TComponent>
+struct Optional {};
+
+/*
+ ViewTerm
+ One template argument of a view. A term decides if an entity is accepted and
+ fetches what the callback receives for it. Required components yield
+ Pool<T>::Reference and const components Pool<T>::ConstReference, that is T& and
+ const T& unless the pool keeps the fields in separate arrays. Non const components
+ count as written and are stamped with the registry tick when they are fetched
+*/
+template <typename T>
+class ViewTerm {
+public:
+	using TComponent = std::remove_const_t<T>;
+	using TReference = std::conditional_t<std::is_const_v<T>, typename Pool<TComponent>::ConstReference, typename Pool<TComponent>::Reference>;
+
+	void Resolve(Registry& registry) {
+		if constexpr (std::is_const_v<T>) {
+			pool = registry.GetPool<TComponent>();
+		}
+		else {
+			pool = registry.GetMutablePool<TComponent>();
+		}
+		componentId = Component<TComponent>::GetId();
+		tick = registry.GetTick();
+	}
+
+	// pool the view can walk, a required component with no pool means an empty view
+	bool CanDrive() const { return true; }
+	const IPool* GetPool() const { return pool; }
+
+	bool Accepts(int entityId) const { return pool->Contains(entityId); }
+	std::tuple<TReference> Fetch(int entityId) const {
+		if constexpr (std::is_const_v<T>) {
+			return std::tuple<TReference>(std::as_const(*pool).Get(entityId));
+		}
+		else {
+			pool->MarkChanged(entityId, tick);
+			return std::tuple<TReference>(pool->Get(entityId));
+		}
+	}
+
+	bool Accepts(const Archetype& archetype) const { return archetype.GetSignature().test(componentId); }
+	void SetChunk(const Archetype& archetype, int chunk) { column = static_cast<TComponent*>(archetype.GetColumn(chunk, componentId)); }
+	std::tuple<TReference> FetchRow(int index) const { return std::tuple<TReference>(TReference(column[index])); }
+
+private:
+	// const components only get the pool for reading, it can be shared with a clone
+	std::conditional_t<std::is_const_v<T>, const Pool<TComponent>, Pool<TComponent>>* pool = nullptr;
+	int componentId = 0;
+	std::uint32_t tick = 0;
+	TComponent* column = nullptr;
+};
+
+template <typename T>
+class ViewTerm<Optional<T>> {
+public:
+	using TComponent = std::remove_const_t<T>;
+	static_assert(Pool<TComponent>::STORES_OBJECTS, "Optional<T> yields a T*, which pools with separate field arrays can't provide");
+
+	void Resolve(Registry& registry) {
+		if constexpr (std::is_const_v<T>) {
+			pool = registry.GetPool<TComponent>();
+		}
+		else {
+			pool = registry.GetMutablePool<TComponent>();
+		}
+		componentId = Component<TComponent>::GetId();
+		tick = registry.GetTick();
+	}
+
+	bool CanDrive() const { return false; }
+	const IPool* GetPool() const { return nullptr; }
+
+	bool Accepts(int entityId) const { return true; }
+	std::tuple<T*> Fetch(int entityId) const {
+		if (!pool || !pool->Contains(entityId)) {
+			return std::tuple<T*>(nullptr);
+		}
+		if constexpr (!std::is_const_v<T>) {
+			pool->MarkChanged(entityId, tick);
+		}
+		return std::tuple<T*>(&pool->Get(entityId));
+	}
+
+	bool Accepts(const Archetype& archetype) const { return true; }
+	void SetChunk(const Archetype& archetype, int chunk) {
+		column = archetype.GetSignature().test(componentId) ? static_cast<TComponent*>(archetype.GetColumn(chunk, componentId)) : nullptr;
+	}
+	std::tuple<T*> FetchRow(int index) const { return std::tuple<T*>(column ? &column[index] : nullptr); }
+
+private:
+	std::conditional_t<std::is_const_v<T>, const Pool<TComponent>, Pool<TComponent>>* pool = nullptr;
+	int componentId = 0;
+	std::uint32_t tick = 0;
+	TComponent* column = nullptr;
+};
+
+template <typename ...TExcluded>
+class ViewTerm<Exclude<TExcluded...>> {
+public:
+	void Resolve(const Registry& registry) {
+		pools = { registry.GetPool<TExcluded>()... };
+		excludedSignature.reset();
+		(excludedSignature.set(Component<TExcluded>::GetId()), ...);
+	}
+
+	bool CanDrive() const { return false; }
+	const IPool* GetPool() const { return nullptr; }
+
+	bool Accepts(int entityId) const {
+		for (const IPool* pool : pools) {
+			if (pool && pool->Contains(entityId)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	std::tuple<> Fetch(int entityId) const { return std::tuple<>(); }
+
+	bool Accepts(const Archetype& archetype) const { return !archetype.GetSignature().Intersects(excludedSignature); }
+	void SetChunk(const Archetype& archetype, int chunk) {}
+	std::tuple<> FetchRow(int index) const { return std::tuple<>(); }
+
+private:
+	std::array<const IPool*, sizeof...(TExcluded)> pools{};
+	Signature excludedSignature;
+};
+
+/*
+ ComponentView
+ Iterates every entity that matches the view terms and hands the callback the
+ entity and references to its components, e.g.
+
+	registry->View<SpriteComponent, const AnimationComponent>().Each(
+		[](Entity entity, SpriteComponent& sprite, const AnimationComponent& animation) { ... });
+
+ With pool storage the smallest required pool is walked and the other pools are
+ probed through their sparse arrays, with archetype storage every matching chunk
+ is walked linearly. Components of the viewed types must not be added or removed
+ inside the callback
+*/
+template <typename ...TComponents>
+class ComponentView {
+public:
+	ComponentView(Registry* registry) : registry(registry) {
+		std::apply([registry](auto&... term) { (term.Resolve(*registry), ...); }, terms);
+	}
+
+	template <typename TFunc>
+	void Each(TFunc func) {
+		if (registry->GetStorageMode() == StorageMode::Archetypes) {
+			EachInArchetypes(func);
+			return;
+		}
+
+		const IPool* drivingPool = FindDrivingPool();
+		if (!drivingPool) {
+			return;
+		}
+
+		for (int entityId : drivingPool->GetEntityIds()) {
+			const bool accepted = std::apply([entityId](const auto&... term) { return (term.Accepts(entityId) && ...); }, terms);
+			if (!accepted) {
+				continue;
+			}
+
+			Entity entity(entityId, registry->entityGenerations[entityId]);
+			entity.registry = registry;
+			std::apply(func, std::tuple_cat(std::make_tuple(entity), std::apply([entityId](const auto&... term) { return std::tuple_cat(term.Fetch(entityId)...); }, terms)));
+		}
+	}
+
+private:
+	// the smallest pool among the required components, nullptr if one of them has no pool
+	const IPool* FindDrivingPool() const {
+		const IPool* drivingPool = nullptr;
+		bool missingPool = false;
+		std::apply([&drivingPool, &missingPool](const auto&... term) {
+			([&] {
+				if (!term.CanDrive()) {
+					return;
+				}
+				const IPool* pool = term.GetPool();
+				if (!pool) {
+					missingPool = true;
+				}
+				else if (!drivingPool || pool->GetSize() < drivingPool->GetSize()) {
+					drivingPool = pool;
+				}
+			}(), ...);
+		}, terms);
+		return missingPool ? nullptr : drivingPool;
+	}
+
+	template <typename TFunc>
+	void EachInArchetypes(TFunc& func) {
+		for (const auto& archetype : registry->archetypeStorage.GetArchetypes()) {
+			const bool accepted = std::apply([&archetype](const auto&... term) { return (term.Accepts(*archetype) && ...); }, terms);
+			if (!accepted) {
+				continue;
+			}
+
+			for (int chunk = 0; chunk < archetype->GetChunkCount(); chunk++) {
+				std::apply([&archetype, chunk](auto&... term) { (term.SetChunk(*archetype, chunk), ...); }, terms);
+				const EntityHandle* handles = archetype->GetHandles(chunk);
+				const int count = archetype->GetChunkEntityCount(chunk);
+
+				for (int index = 0; index < count; index++) {
+					Entity entity(handles[index]);
+					entity.registry = registry;
+					std::apply(func, std::tuple_cat(std::make_tuple(entity), std::apply([index](const auto&... term) { return std::tuple_cat(term.FetchRow(index)...); }, terms)));
+				}
+			}
+		}
+	}
+
+	Registry* registry;
+	std::tuple<ViewTerm<TComponents>...> terms;
+};
+
+template <typename ...TComponents>
+ComponentView<TComponents...> Registry::View() {
+	return ComponentView<TComponents...>(this);
+}
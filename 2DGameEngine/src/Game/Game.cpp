@@ -11,6 +11,7 @@
 #include "..//Components/TextLabelComponent.hpp"
 #include "..//Components/HealthComponent.hpp"
 #include "../Systems/MovementSystem.hpp"
+#include "../Systems/TransformSystem.hpp"
 #include "../Systems/RenderSystem.hpp"
 #include "../Systems/AnimationSystem.hpp"
 #include "../Systems/CollisionSystem.hpp"
@@ -47,8 +48,11 @@ Game::Game(int SCREEN_WIDTH, int SCREEN_HEIGHT) {
 	registry = std::make_unique<Registry>();
 	assetStore = std::make_unique<AssetStore>();
 	eventBus = std::make_unique<EventBus>();
+	jobSystem = std::make_unique<JobSystem>();
+	systemScheduler = std::make_unique<SystemScheduler>(*jobSystem);
 	running = false;
 	debugMode = false;
+	deltaTime = 0.0;
 	Logger::Log("Game constructor called!");
 }
 
@@ -99,6 +103,7 @@ void Game::Initialize() {
 void Game::LoadLevel(int level) {
 	// adding systems to the game
 	registry->AddSystem<MovementSystem>();
+	registry->AddSystem<TransformSystem>();
 	registry->AddSystem<RenderSystem>();
 	registry->AddSystem<AnimationSystem>();
 	registry->AddSystem<CollisionSystem>();
@@ -112,6 +117,12 @@ void Game::LoadLevel(int level) {
 	registry->AddSystem<RenderHealthBarSystem>();
 	registry->AddSystem<RenderGUISystem>();
 
+	// cached health labels are dropped together with the health component
+	RenderHealthBarSystem* healthBarSystem = &registry->GetSystem<RenderHealthBarSystem>();
+	registry->OnRemove<HealthComponent>([healthBarSystem](std::span<const Entity> entities) {
+		healthBarSystem->ReleaseLabels(entities);
+	});
+
 	// building the asset store for the game
 	assetStore->AddTexture(renderer, "tank-image", "assets/images/tank-panther-right.png");
 	assetStore->AddTexture(renderer, "truck-image", "assets/images/truck-ford-right.png");
@@ -130,6 +141,12 @@ void Game::LoadLevel(int level) {
 	std::fstream mapFile;
 	mapFile.open("assets/tilemaps/jungle.map");
 
+	// read every tile first, then create the tiles as one batch
+	std::vector<TransformComponent> tileTransforms;
+	std::vector<SpriteComponent> tileSprites;
+	tileTransforms.reserve(mapNumRows * mapNumCols);
+	tileSprites.reserve(mapNumRows * mapNumCols);
+
 	for (int y = 0; y < mapNumRows; y++) {
 		for (int x = 0; x < mapNumCols; x++) {
 			char ch;
@@ -139,14 +156,17 @@ void Game::LoadLevel(int level) {
 			int srcX = std::atoi(&ch) * tileSize;
 			mapFile.ignore();
 
-			Entity tile = registry->CreateEntity();
-			tile.Group("tiles");
-			tile.AddComponent<TransformComponent>(glm::vec2(x * (tileScale * tileSize), y * (tileScale * tileSize)), glm::vec2(tileScale, tileScale), 0.0);
-			tile.AddComponent<SpriteComponent>("tilemap-image", tileSize, tileSize, 0, false, srcX, srcY);
+			tileTransforms.emplace_back(glm::vec2(x * (tileScale * tileSize), y * (tileScale * tileSize)), glm::vec2(tileScale, tileScale), 0.0);
+			tileSprites.emplace_back("tilemap-image", tileSize, tileSize, 0, false, srcX, srcY);
 		}
 	}
 
 	mapFile.close();
+
+	std::vector<Entity> tiles = registry->CreateEntities(mapNumRows * mapNumCols);
+	registry->GroupEntities(tiles, "tiles");
+	registry->AddComponents<TransformComponent>(tiles, tileTransforms);
+	registry->AddComponents<SpriteComponent>(tiles, tileSprites);
 	mapWidth = mapNumCols * tileSize * tileScale;
 	mapHeight = mapNumRows * tileSize * tileScale;
 
@@ -199,6 +219,40 @@ void Game::LoadLevel(int level) {
 */
 void Game::Setup() {
 	LoadLevel(1);
+
+	// systems are looked up once here, every frame runs the tasks from the scheduler's flat list
+	// event handlers are subscribed again every frame after the event bus is reset
+	systemScheduler->AddTask(registry->GetSystem<DamageSystem>(), [this](DamageSystem& system) { system.SubscribeToEvents(eventBus); }, SystemStage::PreUpdate);
+	systemScheduler->AddTask(registry->GetSystem<KeyboardControlSystem>(), [this](KeyboardControlSystem& system) { system.SubscribeToEvents(eventBus); }, SystemStage::PreUpdate);
+	systemScheduler->AddTask(registry->GetSystem<ProjectileEmitSystem>(), [this](ProjectileEmitSystem& system) { system.SubscribeToEvents(eventBus); }, SystemStage::PreUpdate);
+
+	// registration order is the update order of systems that use the same components
+	systemScheduler->AddTask(registry->GetSystem<MovementSystem>(), [this](MovementSystem& system, double elapsed) { system.Update(elapsed, *jobSystem); });
+	// attached entities follow their parents before anything reads the world transforms
+	systemScheduler->AddTask(registry->GetSystem<TransformSystem>(), [this](TransformSystem& system) { system.Update(*jobSystem); });
+	// animation frames are computed from the clock, so 30 updates a second are enough
+	const int animationTask = systemScheduler->AddTask(registry->GetSystem<AnimationSystem>(), [this](AnimationSystem& system) { system.Update(*jobSystem); });
+	systemScheduler->SetTickRate(animationTask, 30.0);
+	systemScheduler->AddTask(registry->GetSystem<CollisionSystem>(), [this](CollisionSystem& system) { system.Update(eventBus); });
+	systemScheduler->AddTask(registry->GetSystem<ProjectileEmitSystem>(), [this](ProjectileEmitSystem& system) { system.Update(registry); });
+	systemScheduler->AddTask(registry->GetSystem<ProjectileLifeCycleSystem>(), [this](ProjectileLifeCycleSystem& system) { system.Update(*jobSystem); });
+
+	// collisions found in the update stage are applied once all of them are known
+	systemScheduler->AddTask(registry->GetSystem<DamageSystem>(), [](DamageSystem& system) { system.Update(); }, SystemStage::PostUpdate);
+	// the camera follows the player once everything has moved
+	systemScheduler->AddTask(registry->GetSystem<CameraMovementSystem>(), [this](CameraMovementSystem& system) { system.Update(camera); }, SystemStage::PostUpdate);
+
+	systemScheduler->AddTask(registry->GetSystem<RenderSystem>(), [this](RenderSystem& system) { system.Update(renderer, camera, assetStore); }, SystemStage::Render);
+	systemScheduler->AddTask(registry->GetSystem<RenderTextSystem>(), [this](RenderTextSystem& system) { system.Update(renderer, assetStore, camera); }, SystemStage::Render);
+	systemScheduler->AddTask(registry->GetSystem<RenderHealthBarSystem>(), [this](RenderHealthBarSystem& system) { system.Update(renderer, assetStore, camera); }, SystemStage::Render);
+
+	// hit boxes and the GUI only run in debug mode
+	CollisionSystem* collisionSystem = &registry->GetSystem<CollisionSystem>();
+	debugTasks.push_back(systemScheduler->AddTask(registry->GetSystem<RenderColliderSystem>(), [this, collisionSystem](RenderColliderSystem& system) { system.Update(renderer, camera, collisionSystem->GetCollided()); }, SystemStage::Render));
+	debugTasks.push_back(systemScheduler->AddTask(registry->GetSystem<RenderGUISystem>(), [this](RenderGUISystem& system) { system.Update(registry, camera, *systemScheduler); }, SystemStage::Render));
+	for (int task : debugTasks) {
+		systemScheduler->SetEnabled(task, debugMode);
+	}
 }
 
 /*
@@ -210,24 +264,22 @@ void Game::Update() {
 	if (timeToWait > 0 && timeToWait <= MILLISECS_PER_FRAME)
 		SDL_Delay(timeToWait);
 
-	double deltaTime = (SDL_GetTicks() - millisecsPreviousFrame) / 1000.0;
+	deltaTime = (SDL_GetTicks() - millisecsPreviousFrame) / 1000.0;
 
 	millisecsPreviousFrame = SDL_GetTicks();
 
 	eventBus->Reset();
 
-	registry->GetSystem<DamageSystem>().SubscribeToEvents(eventBus);
-	registry->GetSystem<KeyboardControlSystem>().SubscribeToEvents(eventBus);
-	registry->GetSystem<ProjectileEmitSystem>().SubscribeToEvents(eventBus);
-
 	registry->Update();
 
-	registry->GetSystem<MovementSystem>().Update(deltaTime);
-	registry->GetSystem<AnimationSystem>().Update();
-	registry->GetSystem<CollisionSystem>().Update(eventBus);
-	registry->GetSystem<CameraMovementSystem>().Update(camera);
-	registry->GetSystem<ProjectileEmitSystem>().Update(registry);
-	registry->GetSystem<ProjectileLifeCycleSystem>().Update();
+	systemScheduler->BeginFrame(deltaTime);
+	systemScheduler->Run(SystemStage::PreUpdate);
+	systemScheduler->Run(SystemStage::Update);
+	systemScheduler->Run(SystemStage::PostUpdate);
+
+	if (statsDump.is_open()) {
+		registry->GetStats().Write(statsDump);
+	}
 }
 
 /*
@@ -274,6 +326,19 @@ void Game::ProcessInput() {
 			}
 			if (event.key.keysym.sym == SDLK_b) {
 				debugMode = !debugMode;
+				for (int task : debugTasks) {
+					systemScheduler->SetEnabled(task, debugMode);
+				}
+			}
+			if (event.key.keysym.sym == SDLK_m) {
+				if (statsDump.is_open()) {
+					statsDump.close();
+					Logger::Log("Stopped dumping registry stats");
+				}
+				else {
+					statsDump.open("registry-stats.tsv", std::ios::app);
+					Logger::Log("Dumping registry stats to registry-stats.tsv");
+				}
 			}
 			eventBus->EmitEvent<KeyPressedEvent>(event.key.keysym.sym);
 			break;
@@ -292,16 +357,8 @@ void Game::Render() {
 	// clear renderer
 	SDL_RenderClear(renderer);
 
-	// call system update methods for systems that need rendering
-	registry->GetSystem<RenderSystem>().Update(renderer, camera, assetStore);
-	registry->GetSystem<RenderTextSystem>().Update(renderer, assetStore, camera);
-	registry->GetSystem<RenderHealthBarSystem>().Update(renderer, assetStore, camera);
-	if (debugMode) {
-		// show hit boxes
-		registry->GetSystem<RenderColliderSystem>().Update(renderer, camera, registry->GetSystem<CollisionSystem>().GetCollided());
-
-		registry->GetSystem<RenderGUISystem>().Update(registry, camera);
-	}
+	// systems that need rendering, hit boxes and the GUI are only enabled in debug mode
+	systemScheduler->Run(SystemStage::Render);
 	
 	// update the renderer
 	SDL_RenderPresent(renderer);
@@ -6,6 +6,9 @@
 #include "../AssetStore/AssetStore.hpp"
 #include "memory"
 #include "../EventBus/EventBus.hpp"
+#include "../JobSystem/JobSystem.hpp"
+#include "../ECS/SystemScheduler.hpp"
+#include <fstream>
 
 const int FPS = 60;
 const int MILLISECS_PER_FRAME = 1000 / FPS;
@@ -40,8 +43,16 @@ private:
 	static int mapHeight;
 	bool running;
 	bool debugMode;
+	double deltaTime;
+	// registry stats appended every frame while open, toggled with the m key
+	std::ofstream statsDump;
 
 	std::unique_ptr<Registry> registry;
 	std::unique_ptr<AssetStore> assetStore;
 	std::unique_ptr<EventBus> eventBus;
+	std::unique_ptr<JobSystem> jobSystem;
+	// runs the update and render systems, declared after the job system so it is destroyed first
+	std::unique_ptr<SystemScheduler> systemScheduler;
+	// scheduler tasks that only run in debug mode
+	std::vector<int> debugTasks;
 };
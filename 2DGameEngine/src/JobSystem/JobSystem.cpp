@@ -0,0 +1,179 @@
+#include "JobSystem.hpp"
+#include "../Logger/Logger.hpp"
+
+// identifies the job system and queue owned by the current worker thread
+static thread_local const JobSystem* currentJobSystem = nullptr;
+static thread_local int currentQueueIndex = 0;
+
+// JobOrder scope of the current thread
+static thread_local std::uint64_t currentOrderKey = 0;
+static thread_local int currentOrderFreeBits = JobOrder::ROOT_FREE_BITS;
+static thread_local int currentOrderRegion = 0;
+
+JobOrder::Scope::Scope(std::uint64_t key, int freeBits) :
+	savedKey(currentOrderKey), savedFreeBits(currentOrderFreeBits), savedRegion(currentOrderRegion) {
+	currentOrderKey = key;
+	currentOrderFreeBits = freeBits;
+	currentOrderRegion = 0;
+}
+
+JobOrder::Scope::~Scope() {
+	currentOrderKey = savedKey;
+	currentOrderFreeBits = savedFreeBits;
+	currentOrderRegion = savedRegion;
+}
+
+std::uint64_t JobOrder::GetKey() {
+	if (currentOrderFreeBits < REGION_BITS) {
+		return currentOrderKey;
+	}
+	// even regions hold what the scope records itself, odd ones the chunks of a ParallelFor()
+	return currentOrderKey | (static_cast<std::uint64_t>(currentOrderRegion * 2) << (currentOrderFreeBits - REGION_BITS));
+}
+
+bool JobOrder::BeginRegion(Region& region) {
+	// the even region after this one has to fit as well
+	const int regionIndex = currentOrderRegion * 2 + 1;
+	if (currentOrderFreeBits < REGION_BITS + CHUNK_BITS || regionIndex + 1 >= (1 << REGION_BITS)) {
+		return false;
+	}
+	region.freeBits = currentOrderFreeBits - REGION_BITS - CHUNK_BITS;
+	region.key = currentOrderKey | (static_cast<std::uint64_t>(regionIndex) << (currentOrderFreeBits - REGION_BITS));
+	currentOrderRegion++;
+	return true;
+}
+
+void JobSystem::JobQueue::PushBack(Job&& job) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (size == ring.size()) {
+		// grow and unwrap, the ring keeps its capacity afterwards
+		std::vector<Job> grown(std::max<size_t>(64, ring.size() * 2));
+		for (size_t i = 0; i < size; i++) {
+			grown[i] = std::move(ring[(head + i) % ring.size()]);
+		}
+		ring = std::move(grown);
+		head = 0;
+	}
+	ring[(head + size) % ring.size()] = std::move(job);
+	size++;
+}
+
+bool JobSystem::JobQueue::PopBack(Job& job) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (size == 0) {
+		return false;
+	}
+	size--;
+	job = std::move(ring[(head + size) % ring.size()]);
+	return true;
+}
+
+bool JobSystem::JobQueue::PopFront(Job& job) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (size == 0) {
+		return false;
+	}
+	job = std::move(ring[head]);
+	head = (head + 1) % ring.size();
+	size--;
+	return true;
+}
+
+JobSystem::JobSystem(int numWorkers) {
+	for (int i = 0; i <= numWorkers; i++) {
+		queues.push_back(std::make_unique<JobQueue>());
+	}
+	for (int i = 0; i < numWorkers; i++) {
+		workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+	}
+	Logger::Log("JobSystem started with " + std::to_string(numWorkers) + " worker threads");
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	jobsAvailable.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+int JobSystem::DefaultWorkerCount() {
+	// leave one hardware thread for the thread that submits and waits
+	const int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+	return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+int JobSystem::GetThreadCount() const {
+	return static_cast<int>(workers.size()) + 1;
+}
+
+int JobSystem::GetQueueIndex() const {
+	return currentJobSystem == this ? currentQueueIndex : 0;
+}
+
+void JobSystem::Submit(std::function<void()> job, JobCounter& counter) {
+	counter.count.fetch_add(1, std::memory_order_relaxed);
+	queues[GetQueueIndex()]->PushBack({ std::move(job), &counter });
+	queuedJobs.fetch_add(1, std::memory_order_release);
+	if (!workers.empty()) {
+		// taking the lock makes sure a worker about to sleep sees the new job
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		jobsAvailable.notify_one();
+	}
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+	const int queueIndex = GetQueueIndex();
+	while (!counter.IsDone()) {
+		if (!TryRunJob(queueIndex)) {
+			// the remaining jobs are running on other threads
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::TryRunJob(int queueIndex) {
+	Job job;
+	// newest own job first, it is the most likely to still be in cache
+	if (queues[queueIndex]->PopBack(job)) {
+		RunJob(job);
+		return true;
+	}
+	// steal the oldest job of another queue
+	for (size_t i = 1; i < queues.size(); i++) {
+		if (queues[(queueIndex + i) % queues.size()]->PopFront(job)) {
+			RunJob(job);
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::RunJob(Job& job) {
+	queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+	{
+		// a job run by Wait() doesn't record under the key of the job that waits
+		JobOrder::Scope scope(0, JobOrder::ROOT_FREE_BITS);
+		job.function();
+	}
+	job.counter->count.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::WorkerLoop(int queueIndex) {
+	currentJobSystem = this;
+	currentQueueIndex = queueIndex;
+
+	while (true) {
+		if (TryRunJob(queueIndex)) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		jobsAvailable.wait(lock, [this]() { return stopping || queuedJobs.load(std::memory_order_acquire) > 0; });
+		if (stopping) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ JobCounter
+ Counts the jobs of a batch that haven't finished yet, a batch is done
+ when its counter reaches zero
+*/
+struct JobCounter {
+	std::atomic<int> count{ 0 };
+
+	bool IsDone() const {
+		return count.load(std::memory_order_acquire) == 0;
+	}
+};
+
+/*
+ JobOrder
+ Ordering key of the work the current thread is running, for results that are
+ merged after the jobs finish and have to come out in the same order whichever
+ thread produced them, e.g. CommandBuffer commands. The scheduler opens a scope
+ per system task and ParallelFor() opens one per chunk, under the key of the
+ scope that called it. Keys compare like running everything on one thread: what
+ a scope records before a ParallelFor(), then the chunks in chunk order, then
+ what it records after it.
+ A scope has freeBits low bits below its key, 10 for its ParallelFor() regions,
+ 10 for the chunk index and the rest for the chunks' own scopes. A ParallelFor()
+ that finds no bits or regions left runs its chunks in order on the calling
+ thread, which keeps the order. Work outside any scope has key 0
+*/
+class JobOrder {
+public:
+	// low bits of a root scope, the scheduler puts the stage and task above them
+	static constexpr int ROOT_FREE_BITS = 48;
+	static constexpr int REGION_BITS = 10;
+	static constexpr int CHUNK_BITS = 10;
+	static constexpr int MAX_CHUNKS = 1 << CHUNK_BITS;
+
+	/*
+	 Scope
+	 Makes key the ordering key of the current thread until it is destroyed, then
+	 puts back the scope it replaced. Jobs that run inside Wait() open their own
+	 scope, so they never change the key of the job that waits
+	*/
+	class Scope {
+	public:
+		Scope(std::uint64_t key, int freeBits);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator = (const Scope&) = delete;
+
+	private:
+		std::uint64_t savedKey;
+		int savedFreeBits;
+		int savedRegion;
+	};
+
+	// keys of the chunks of one ParallelFor()
+	struct Region {
+		std::uint64_t key = 0;
+		int freeBits = 0;
+
+		std::uint64_t GetChunkKey(int chunk) const {
+			return key | (static_cast<std::uint64_t>(chunk) << freeBits);
+		}
+	};
+
+	// key of what the current thread records now
+	static std::uint64_t GetKey();
+	// take the next region of the current scope, false if it has no bits or regions left
+	static bool BeginRegion(Region& region);
+};
+
+/*
+ JobSystem
+ Work stealing job system. Every worker thread owns a deque of jobs: it pushes
+ and pops its own jobs at the back and steals from the front of the other
+ deques when it runs out. Threads that aren't workers share one extra deque,
+ and a thread that waits on a counter runs jobs until the counter is done
+*/
+class JobSystem {
+public:
+	// numWorkers = 0 runs every job on the waiting thread
+	JobSystem(int numWorkers = DefaultWorkerCount());
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator = (const JobSystem&) = delete;
+
+	// queue a job, the counter is incremented now and decremented once the job has run
+	void Submit(std::function<void()> job, JobCounter& counter);
+	// run jobs on the calling thread until the counter reaches zero
+	void Wait(JobCounter& counter);
+
+	/*
+	 Split [0, count) into chunks and call func(begin, end) for each chunk, the
+	 calling thread runs chunks too and returns once all of them are done.
+	 Ranges smaller than minChunkSize run on the calling thread only
+	*/
+	template <typename TFunc> void ParallelFor(int count, TFunc&& func, int minChunkSize = 1024);
+
+	// worker threads plus the waiting thread
+	int GetThreadCount() const;
+
+	static int DefaultWorkerCount();
+
+private:
+	struct Job {
+		std::function<void()> function;
+		JobCounter* counter = nullptr;
+	};
+
+	/*
+	 JobQueue
+	 Growable ring buffer guarded by a mutex, the owner uses the back and
+	 thieves use the front
+	*/
+	class JobQueue {
+	public:
+		void PushBack(Job&& job);
+		bool PopBack(Job& job);
+		bool PopFront(Job& job);
+
+	private:
+		std::mutex mutex;
+		std::vector<Job> ring;
+		size_t head = 0;
+		size_t size = 0;
+	};
+
+	// chunked range shared by the jobs of one ParallelFor()
+	struct ParallelRange {
+		void (*invoke)(void* func, int begin, int end);
+		void* func;
+		int count;
+		int chunkSize;
+		JobOrder::Region region;
+	};
+
+	int GetQueueIndex() const;
+	bool TryRunJob(int queueIndex);
+	void RunJob(Job& job);
+	void WorkerLoop(int queueIndex);
+
+	std::vector<std::thread> workers;
+	// queue 0 is shared by threads that aren't workers, worker i owns queue i + 1
+	std::vector<std::unique_ptr<JobQueue>> queues;
+	std::atomic<int> queuedJobs{ 0 };
+	std::mutex sleepMutex;
+	std::condition_variable jobsAvailable;
+	bool stopping = false;
+};
+
+template <typename TFunc>
+void JobSystem::ParallelFor(int count, TFunc&& func, int minChunkSize) {
+	if (count <= 0) {
+		return;
+	}
+
+	// a few chunks per thread so threads that finish early can steal the rest
+	const int maxChunks = GetThreadCount() * 4;
+	const int chunkCount = std::max(1, std::min({ maxChunks, JobOrder::MAX_CHUNKS, count / std::max(1, minChunkSize) }));
+	// without a region of its own the chunks run in order on this thread, under the key of the caller
+	JobOrder::Region region;
+	if (chunkCount == 1 || !JobOrder::BeginRegion(region)) {
+		func(0, count);
+		return;
+	}
+
+	using TFuncType = std::remove_reference_t<TFunc>;
+	ParallelRange range;
+	range.invoke = [](void* f, int begin, int end) { (*static_cast<TFuncType*>(f))(begin, end); };
+	range.func = const_cast<void*>(static_cast<const void*>(&func));
+	range.count = count;
+	range.chunkSize = (count + chunkCount - 1) / chunkCount;
+	range.region = region;
+
+	// the jobs only capture a pointer and an index, small enough to never allocate
+	JobCounter counter;
+	for (int chunk = 1; chunk < chunkCount; chunk++) {
+		Submit([rangePtr = &range, chunk]() {
+			const int begin = chunk * rangePtr->chunkSize;
+			const int end = std::min(rangePtr->count, begin + rangePtr->chunkSize);
+			if (begin < end) {
+				JobOrder::Scope scope(rangePtr->region.GetChunkKey(chunk), rangePtr->region.freeBits);
+				rangePtr->invoke(rangePtr->func, begin, end);
+			}
+		}, counter);
+	}
+	{
+		JobOrder::Scope scope(region.GetChunkKey(0), region.freeBits);
+		func(0, std::min(count, range.chunkSize));
+	}
+	Wait(counter);
+}
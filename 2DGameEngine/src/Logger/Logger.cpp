@@ -1,8 +1,12 @@
 #include "Logger.hpp"
+#include <mutex>
 
 // Creates a vector to hold the log messages
 std::vector<LogEntry> Logger::messages;
 
+// Systems can log from worker threads, so output and the message list are guarded
+static std::mutex logMutex;
+
 /*
 	Function gets current time in the correct format as a string
 	@return current time as string
@@ -23,6 +27,7 @@ void Logger::Log(const std::string& message) {
 	LogEntry logEntry;
 	logEntry.type = LOG_INFO;
 	logEntry.message = "LOG: [" + CurrentTimeToString() + "] " + message;
+	std::lock_guard<std::mutex> lock(logMutex);
 	std::cout << "\x1B[32m" << logEntry.message << "\033[0m" << std::endl;
 	messages.push_back(logEntry);
 }
@@ -34,6 +39,7 @@ void Logger::Err(const std::string& message) {
 	LogEntry logEntry;
 	logEntry.type = LOG_ERROR;
 	logEntry.message = "ERR: [" + CurrentTimeToString() + "] " + message;
+	std::lock_guard<std::mutex> lock(logMutex);
 	std::cout << "\x1B[32m" << logEntry.message << "\033[0m" << std::endl;
 	messages.push_back(logEntry);
 }
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "Integration.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define INTEGRATION_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// gcc and clang only emit vector instructions in functions that ask for them, msvc always does
+#if defined(__GNUC__)
+#define INTEGRATION_TARGET(isa) __attribute__((target(isa)))
+#else
+#define INTEGRATION_TARGET(isa)
+#endif
+
+using KernelFunction = void (*)(const IntegrationArrays& arrays, int begin, int end, float deltaTime, std::uint32_t tick);
+
+static void IntegrateScalar(const IntegrationArrays& arrays, int begin, int end, float deltaTime, std::uint32_t tick) {
+	for (int i = begin; i < end; i++) {
+		const float velocityX = (arrays.velocityX[i] + arrays.accelerationX[i] * deltaTime) / (1.0f + arrays.damping[i] * deltaTime);
+		const float velocityY = (arrays.velocityY[i] + arrays.accelerationY[i] * deltaTime) / (1.0f + arrays.damping[i] * deltaTime);
+		const bool velocityChanged = (velocityX != arrays.velocityX[i]) | (velocityY != arrays.velocityY[i]);
+		const bool moving = (velocityX != 0.0f) | (velocityY != 0.0f);
+
+		arrays.velocityX[i] = velocityX;
+		arrays.velocityY[i] = velocityY;
+		arrays.positionX[i] = arrays.positionX[i] + velocityX * deltaTime;
+		arrays.positionY[i] = arrays.positionY[i] + velocityY * deltaTime;
+		arrays.transformTicks[i] = moving ? tick : arrays.transformTicks[i];
+		arrays.rigidBodyTicks[i] = velocityChanged ? tick : arrays.rigidBodyTicks[i];
+	}
+}
+
+#if defined(INTEGRATION_X86)
+
+INTEGRATION_TARGET("sse2")
+static void IntegrateSSE2(const IntegrationArrays& arrays, int begin, int end, float deltaTime, std::uint32_t tick) {
+	const __m128 step = _mm_set1_ps(deltaTime);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128i tickValue = _mm_set1_epi32(static_cast<int>(tick));
+
+	int i = begin;
+	for (; i + 4 <= end; i += 4) {
+		const __m128 oldVelocityX = _mm_loadu_ps(arrays.velocityX + i);
+		const __m128 oldVelocityY = _mm_loadu_ps(arrays.velocityY + i);
+		const __m128 divisor = _mm_add_ps(one, _mm_mul_ps(_mm_loadu_ps(arrays.damping + i), step));
+		const __m128 velocityX = _mm_div_ps(_mm_add_ps(oldVelocityX, _mm_mul_ps(_mm_loadu_ps(arrays.accelerationX + i), step)), divisor);
+		const __m128 velocityY = _mm_div_ps(_mm_add_ps(oldVelocityY, _mm_mul_ps(_mm_loadu_ps(arrays.accelerationY + i), step)), divisor);
+
+		_mm_storeu_ps(arrays.velocityX + i, velocityX);
+		_mm_storeu_ps(arrays.velocityY + i, velocityY);
+		_mm_storeu_ps(arrays.positionX + i, _mm_add_ps(_mm_loadu_ps(arrays.positionX + i), _mm_mul_ps(velocityX, step)));
+		_mm_storeu_ps(arrays.positionY + i, _mm_add_ps(_mm_loadu_ps(arrays.positionY + i), _mm_mul_ps(velocityY, step)));
+
+		// sse2 has no integer blend, select the ticks with and / andnot / or
+		const __m128i moving = _mm_castps_si128(_mm_or_ps(_mm_cmpneq_ps(velocityX, zero), _mm_cmpneq_ps(velocityY, zero)));
+		const __m128i velocityChanged = _mm_castps_si128(_mm_or_ps(_mm_cmpneq_ps(velocityX, oldVelocityX), _mm_cmpneq_ps(velocityY, oldVelocityY)));
+		__m128i* transformTicks = reinterpret_cast<__m128i*>(arrays.transformTicks + i);
+		__m128i* rigidBodyTicks = reinterpret_cast<__m128i*>(arrays.rigidBodyTicks + i);
+		_mm_storeu_si128(transformTicks, _mm_or_si128(_mm_and_si128(moving, tickValue), _mm_andnot_si128(moving, _mm_loadu_si128(transformTicks))));
+		_mm_storeu_si128(rigidBodyTicks, _mm_or_si128(_mm_and_si128(velocityChanged, tickValue), _mm_andnot_si128(velocityChanged, _mm_loadu_si128(rigidBodyTicks))));
+	}
+	IntegrateScalar(arrays, i, end, deltaTime, tick);
+}
+
+INTEGRATION_TARGET("avx2")
+static void IntegrateAVX2(const IntegrationArrays& arrays, int begin, int end, float deltaTime, std::uint32_t tick) {
+	const __m256 step = _mm256_set1_ps(deltaTime);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256i tickValue = _mm256_set1_epi32(static_cast<int>(tick));
+
+	int i = begin;
+	for (; i + 8 <= end; i += 8) {
+		const __m256 oldVelocityX = _mm256_loadu_ps(arrays.velocityX + i);
+		const __m256 oldVelocityY = _mm256_loadu_ps(arrays.velocityY + i);
+		const __m256 divisor = _mm256_add_ps(one, _mm256_mul_ps(_mm256_loadu_ps(arrays.damping + i), step));
+		const __m256 velocityX = _mm256_div_ps(_mm256_add_ps(oldVelocityX, _mm256_mul_ps(_mm256_loadu_ps(arrays.accelerationX + i), step)), divisor);
+		const __m256 velocityY = _mm256_div_ps(_mm256_add_ps(oldVelocityY, _mm256_mul_ps(_mm256_loadu_ps(arrays.accelerationY + i), step)), divisor);
+
+		_mm256_storeu_ps(arrays.velocityX + i, velocityX);
+		_mm256_storeu_ps(arrays.velocityY + i, velocityY);
+		// separate multiply and add rather than fma, so the results match the other kernels
+		_mm256_storeu_ps(arrays.positionX + i, _mm256_add_ps(_mm256_loadu_ps(arrays.positionX + i), _mm256_mul_ps(velocityX, step)));
+		_mm256_storeu_ps(arrays.positionY + i, _mm256_add_ps(_mm256_loadu_ps(arrays.positionY + i), _mm256_mul_ps(velocityY, step)));
+
+		const __m256i moving = _mm256_castps_si256(_mm256_or_ps(_mm256_cmp_ps(velocityX, zero, _CMP_NEQ_UQ), _mm256_cmp_ps(velocityY, zero, _CMP_NEQ_UQ)));
+		const __m256i velocityChanged = _mm256_castps_si256(_mm256_or_ps(_mm256_cmp_ps(velocityX, oldVelocityX, _CMP_NEQ_UQ), _mm256_cmp_ps(velocityY, oldVelocityY, _CMP_NEQ_UQ)));
+		__m256i* transformTicks = reinterpret_cast<__m256i*>(arrays.transformTicks + i);
+		__m256i* rigidBodyTicks = reinterpret_cast<__m256i*>(arrays.rigidBodyTicks + i);
+		_mm256_storeu_si256(transformTicks, _mm256_blendv_epi8(_mm256_loadu_si256(transformTicks), tickValue, moving));
+		_mm256_storeu_si256(rigidBodyTicks, _mm256_blendv_epi8(_mm256_loadu_si256(rigidBodyTicks), tickValue, velocityChanged));
+	}
+	IntegrateScalar(arrays, i, end, deltaTime, tick);
+}
+
+static bool CpuSupportsSSE2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	return __builtin_cpu_supports("sse2");
+#endif
+}
+
+static bool CpuSupportsAVX2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	// the os must save the ymm registers on context switches, checked through xgetbv
+	__cpuid(info, 1);
+	const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+	__cpuidex(info, 7, 0);
+	return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+static KernelFunction GetKernelFunction(Integration::Kernel kernel) {
+#if defined(INTEGRATION_X86)
+	if (kernel == Integration::Kernel::AVX2) {
+		return &IntegrateAVX2;
+	}
+	if (kernel == Integration::Kernel::SSE2) {
+		return &IntegrateSSE2;
+	}
+#endif
+	return &IntegrateScalar;
+}
+
+void Integration::Integrate(const IntegrationArrays& arrays, int begin, int end, float deltaTime, std::uint32_t tick) {
+	static const KernelFunction bestKernel = GetKernelFunction(GetBestKernel());
+	bestKernel(arrays, begin, end, deltaTime, tick);
+}
+
+void Integration::Integrate(Kernel kernel, const IntegrationArrays& arrays, int begin, int end, float deltaTime, std::uint32_t tick) {
+	GetKernelFunction(IsSupported(kernel) ? kernel : Kernel::Scalar)(arrays, begin, end, deltaTime, tick);
+}
+
+Integration::Kernel Integration::GetBestKernel() {
+	static const Kernel bestKernel = IsSupported(Kernel::AVX2) ? Kernel::AVX2 : (IsSupported(Kernel::SSE2) ? Kernel::SSE2 : Kernel::Scalar);
+	return bestKernel;
+}
+
+bool Integration::IsSupported(Kernel kernel) {
+	switch (kernel) {
+#if defined(INTEGRATION_X86)
+		case Kernel::AVX2:
+			return CpuSupportsAVX2();
+		case Kernel::SSE2:
+			return CpuSupportsSSE2();
+#endif
+		case Kernel::Scalar:
+			return true;
+		default:
+			return false;
+	}
+}
+
+const char* Integration::GetKernelName(Kernel kernel) {
+	switch (kernel) {
+		case Kernel::AVX2:
+			return "AVX2";
+		case Kernel::SSE2:
+			return "SSE2";
+		default:
+			return "Scalar";
+	}
+}
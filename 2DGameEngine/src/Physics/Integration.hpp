@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ IntegrationArrays
+ Packed field arrays of the bodies to integrate, index i of every array belongs
+ to the same body. Ticks are the change ticks of the transform and rigid body
+ pools, a body that ends the step with a non zero velocity has its transform
+ stamped, a body whose velocity changed has its rigid body stamped
+*/
+struct IntegrationArrays {
+	float* positionX;
+	float* positionY;
+	float* velocityX;
+	float* velocityY;
+	const float* accelerationX;
+	const float* accelerationY;
+	const float* damping;
+	std::uint32_t* transformTicks;
+	std::uint32_t* rigidBodyTicks;
+};
+
+/*
+ Integration
+ Semi implicit Euler step over whole ranges of bodies:
+	velocity = (velocity + acceleration * deltaTime) / (1 + damping * deltaTime)
+	position = position + velocity * deltaTime
+ The SSE2 and AVX2 kernels do the same float operations in the same order as the
+ scalar one, so every kernel produces the same results. The kernel is picked once
+ from what the CPU supports
+*/
+class Integration {
+public:
+	enum class Kernel {
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	// integrate bodies [begin, end) with the fastest kernel the CPU supports
+	static void Integrate(const IntegrationArrays& arrays, int begin, int end, float deltaTime, std::uint32_t tick);
+	// integrate with a given kernel, falls back to scalar if the CPU doesn't support it
+	static void Integrate(Kernel kernel, const IntegrationArrays& arrays, int begin, int end, float deltaTime, std::uint32_t tick);
+
+	static Kernel GetBestKernel();
+	static bool IsSupported(Kernel kernel);
+	static const char* GetKernelName(Kernel kernel);
+};
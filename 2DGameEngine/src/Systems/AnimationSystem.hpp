@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../ECS/ECS.hpp"
+#include "../JobSystem/JobSystem.hpp"
 #include "../Components/SpriteComponent.hpp"
 #include "../Components/AnimationComponent.hpp"
 #include <SDL.h>
@@ -12,14 +13,18 @@ public:
 		RequireComponent<AnimationComponent>();
 	}
 
-	void Update() {
-		for (Entity entity : GetSystemEntities()) {
-			AnimationComponent& animation = entity.GetComponent<AnimationComponent>();
-			SpriteComponent& sprite = entity.GetComponent<SpriteComponent>();
+	void Update(JobSystem& jobSystem) {
+		const SystemEntities entities = GetSystemEntities();
+		const Uint32 ticks = SDL_GetTicks();
+		jobSystem.ParallelFor(static_cast<int>(entities.size()), [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				Entity entity = entities[i];
+				AnimationComponent& animation = GetMutableComponent<AnimationComponent>(entity);
+				SpriteComponent& sprite = GetMutableComponent<SpriteComponent>(entity);
 
-			animation.currentFrame = ((SDL_GetTicks() - animation.startTime) * animation.frameSpeedRate / 1000) % animation.numFrames;
-			sprite.src.x = animation.currentFrame * sprite.width;
-
-		}
+				animation.currentFrame = ((ticks - animation.startTime) * animation.frameSpeedRate / 1000) % animation.numFrames;
+				sprite.src.x = animation.currentFrame * sprite.width;
+			}
+		});
 	}
-};
\ No newline at end of file
+};
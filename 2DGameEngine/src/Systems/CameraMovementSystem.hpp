@@ -9,14 +9,19 @@
 class CameraMovementSystem : public System {
 public:
 	CameraMovementSystem() {
-		RequireComponent<TransformComponent>();
-		RequireComponent<CameraFollowComponent>();
+		RequireComponent<TransformComponent>(ComponentAccess::Read);
+		RequireComponent<CameraFollowComponent>(ComponentAccess::Read);
 	}
 
 
 	void Update(SDL_Rect& camera) {
 		for (Entity entity : GetSystemEntities()) {
-			TransformComponent transform = entity.GetComponent<TransformComponent>();
+			// the camera only moves when the followed entity moved
+			if (!HasChanged<TransformComponent>(entity)) {
+				continue;
+			}
+
+			const TransformComponent& transform = GetComponent<TransformComponent>(entity);
 			
 			if (transform.position.x + (camera.w / 2) < Game::getMapWidth())
 				camera.x = transform.position.x - (Game::getWidth() / 2);
@@ -29,5 +34,6 @@ public:
 			camera.x = camera.x > camera.w ? camera.w : camera.x;
 			camera.y = camera.y > camera.h ? camera.h : camera.y;
 		}
+		MarkRun();
 	}
 };
\ No newline at end of file
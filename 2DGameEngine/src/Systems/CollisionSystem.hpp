@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../ECS/ECS.hpp"
+#include "../ECS/View.hpp"
 #include "../Components/TransformComponent.hpp"
 #include "../Components/BoxColliderComponent.hpp"
 #include "../EventBus/EventBus.hpp"
@@ -10,8 +11,9 @@
 class CollisionSystem: public System {
 public:
 	CollisionSystem() {
-		RequireComponent<TransformComponent>();
-		RequireComponent<BoxColliderComponent>();
+		RequireComponent<TransformComponent>(ComponentAccess::Read);
+		RequireComponent<BoxColliderComponent>(ComponentAccess::Read);
+		// collision handlers run while this system runs, they only queue work for their own systems, see DamageSystem
 		collided = false;
 	}
 
@@ -21,32 +23,32 @@ public:
 
 	void Update(std::unique_ptr<EventBus>& eventBus) {
 
-		std::vector<Entity> entities = GetSystemEntities();
+		// gather the colliders once so the pair loop doesn't look components up again
+		collidableEntities.clear();
+		registry->View<const TransformComponent, const BoxColliderComponent>().Each([this](Entity entity, const TransformComponent& transform, const BoxColliderComponent& collider) {
+			collidableEntities.push_back({ entity, transform.position, &collider });
+		});
 
 		// loop through entities system is interested in
-		for (std::vector<Entity>::iterator i = entities.begin(); i != entities.end(); i ++) {
-			Entity a = *i;
+		for (auto i = collidableEntities.begin(); i != collidableEntities.end(); i++) {
+			Entity a = i->entity;
 
-			TransformComponent aTransform = a.GetComponent<TransformComponent>();
-			BoxColliderComponent aCollider = a.GetComponent<BoxColliderComponent>();
+			const glm::vec2 aPosition = i->position;
+			const BoxColliderComponent& aCollider = *i->collider;
 
-			for (std::vector<Entity>::iterator j = i; j != entities.end(); j++) {
-				Entity b = *j;
+			for (auto j = i + 1; j != collidableEntities.end(); j++) {
+				Entity b = j->entity;
 
-				if (a == b) {
-					continue;
-				}
-
-				TransformComponent bTransform = b.GetComponent<TransformComponent>();
-				BoxColliderComponent bCollider = b.GetComponent<BoxColliderComponent>();
+				const glm::vec2 bPosition = j->position;
+				const BoxColliderComponent& bCollider = *j->collider;
 
 				collided = CheckAABBCollision(
-					aTransform.position.x + aCollider.offset.x,
-					aTransform.position.y + aCollider.offset.y,
+					aPosition.x + aCollider.offset.x,
+					aPosition.y + aCollider.offset.y,
 					aCollider.width,
 					aCollider.height,
-					bTransform.position.x + bCollider.offset.x,
-					bTransform.position.y + bCollider.offset.y,
+					bPosition.x + bCollider.offset.x,
+					bPosition.y + bCollider.offset.y,
 					bCollider.width,
 					bCollider.height
 			    );
@@ -69,5 +71,13 @@ public:
 	}
 
 private:
+	struct CollidableEntity {
+		Entity entity;
+		// the pair loop only needs the position, copied out of the transform
+		glm::vec2 position;
+		const BoxColliderComponent* collider;
+	};
+
 	bool collided;
+	std::vector<CollidableEntity> collidableEntities;
 };
\ No newline at end of file
@@ -1,16 +1,25 @@
 #pragma once
 
 #include "../ECS/ECS.hpp"
+#include "../ECS/CommandBuffer.hpp"
 #include "../Components/BoxColliderComponent.hpp"
 #include "../Components/ProjectileComponent.hpp"
 #include "../Components/HealthComponent.hpp"
 #include "../EventBus/EventBus.hpp"
 #include "../Events/CollisionEvent.hpp"
+#include <vector>
 
 class DamageSystem : public System {
 public:
 	DamageSystem() {
-		RequireComponent<BoxColliderComponent>();
+		RequireComponent<BoxColliderComponent>(ComponentAccess::Read);
+		AccessComponent<HealthComponent>(ComponentAccess::Write);
+		AccessComponent<ProjectileComponent>(ComponentAccess::Read);
+
+		// checked on every collision, so the names are looked up once
+		playerTag = Registry::GetTagId("player");
+		projectilesGroup = Registry::GetGroupId("projectiles");
+		enemiesGroup = Registry::GetGroupId("enemies");
 	}
 
 	void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus) {
@@ -23,41 +32,53 @@ public:
 		Logger::Log("The Damage System received an event collision between entities " +
 			std::to_string(a.GetId()) + " and " + std::to_string(b.GetId()));
 		
-		if (a.BelongsToGroup("projectiles") && b.HasTag("player")){
-			OnProjectileHitsPlayer(a, b);
+		// the handler runs inside the CollisionSystem task, the hits are applied by Update()
+		if (a.BelongsToGroup(projectilesGroup) && b.HasTag(playerTag)){
+			hits.push_back({ a, b, true });
 		}
 
-		if (b.BelongsToGroup("projectiles") && a.HasTag("player")) {
-			OnProjectileHitsPlayer(b, a);
+		if (b.BelongsToGroup(projectilesGroup) && a.HasTag(playerTag)) {
+			hits.push_back({ b, a, true });
 		}
 
-		if (a.BelongsToGroup("projectiles") && b.BelongsToGroup("enemies")) {
-			OnProjectileHitsEnemy(a, b);
+		if (a.BelongsToGroup(projectilesGroup) && b.BelongsToGroup(enemiesGroup)) {
+			hits.push_back({ a, b, false });
 		}
 
-		if (b.BelongsToGroup("projectiles") && a.BelongsToGroup("enemies")) {
-			OnProjectileHitsEnemy(b, a);
+		if (b.BelongsToGroup(projectilesGroup) && a.BelongsToGroup(enemiesGroup)) {
+			hits.push_back({ b, a, false });
 		}
 
 	}
 
+	// apply the hits queued since the last update, in the order they collided
 	void Update() {
-
+		for (const Hit& hit : hits) {
+			if (hit.targetIsPlayer) {
+				OnProjectileHitsPlayer(hit.projectile, hit.target);
+			}
+			else {
+				OnProjectileHitsEnemy(hit.projectile, hit.target);
+			}
+		}
+		hits.clear();
 	}
 
 	void OnProjectileHitsPlayer(Entity projectile, Entity player) {
 		ProjectileComponent projectileComponent = projectile.GetComponent<ProjectileComponent>();
 
 		if (!projectileComponent.isFriendly) {
-			HealthComponent& health = player.GetComponent<HealthComponent>();
+			HealthComponent& health = player.GetMutableComponent<HealthComponent>();
 
 			health.healthPercentage -= projectileComponent.hitPercentDamage;
 
+			// kills are recorded, the update can run on a worker thread
+			CommandBuffer& commands = registry->GetCommandBuffer();
 			if (health.healthPercentage <= 0) {
-				player.Kill();
+				commands.KillEntity(player);
 			}
 
-			projectile.Kill();
+			commands.KillEntity(projectile);
 		}
 	}
 
@@ -65,15 +86,30 @@ public:
 		ProjectileComponent projectileComponent = projectile.GetComponent<ProjectileComponent>();
 
 		if (projectileComponent.isFriendly) {
-			HealthComponent& health = enemy.GetComponent<HealthComponent>();
+			HealthComponent& health = enemy.GetMutableComponent<HealthComponent>();
 
 			health.healthPercentage -= projectileComponent.hitPercentDamage;
 
+			// kills are recorded, the update can run on a worker thread
+			CommandBuffer& commands = registry->GetCommandBuffer();
 			if (health.healthPercentage <= 0) {
-				enemy.Kill();
+				commands.KillEntity(enemy);
 			}
 
-			projectile.Kill();
+			commands.KillEntity(projectile);
 		}
 	}
+
+private:
+	struct Hit {
+		Entity projectile;
+		Entity target;
+		bool targetIsPlayer;
+	};
+
+	// collisions of the current frame, reused between frames
+	std::vector<Hit> hits;
+	int playerTag;
+	int projectilesGroup;
+	int enemiesGroup;
 };
\ No newline at end of file
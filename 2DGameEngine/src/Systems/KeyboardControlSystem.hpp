@@ -11,7 +11,7 @@ class KeyboardControlSystem : public System {
 public:
 
 	KeyboardControlSystem() {
-		RequireComponent<KeyboardControlledComponent>();
+		RequireComponent<KeyboardControlledComponent>(ComponentAccess::Read);
 		RequireComponent<SpriteComponent>();
 		RequireComponent<RigidBodyComponent>();
 	}
@@ -22,9 +22,9 @@ public:
 
 	void onKeyPressed(KeyPressedEvent& event) {
 		for (Entity entity : GetSystemEntities()) {
-			const KeyboardControlledComponent keyboardControl = entity.GetComponent<KeyboardControlledComponent>();
-			SpriteComponent& sprite = entity.GetComponent<SpriteComponent>();
-			RigidBodyComponent& rigidBody = entity.GetComponent<RigidBodyComponent>();
+			const KeyboardControlledComponent& keyboardControl = GetComponent<KeyboardControlledComponent>(entity);
+			SpriteComponent& sprite = GetMutableComponent<SpriteComponent>(entity);
+			auto rigidBody = GetMutableComponent<RigidBodyComponent>(entity);
 
 			switch (event.symbol) {
 				case SDLK_w:
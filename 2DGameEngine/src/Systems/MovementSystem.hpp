@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../ECS/ECS.hpp"
+#include "../JobSystem/JobSystem.hpp"
+#include "../Physics/Integration.hpp"
 #include "../Components/TransformComponent.hpp"
 #include "../Components/RigidBodyComponent.hpp"
 
@@ -8,17 +10,80 @@ class MovementSystem : public System{
 public:
 	MovementSystem() {
 		RequireComponent<TransformComponent>();
+		// write access, velocities are integrated and the pool is reordered to line up with the transform pool
 		RequireComponent<RigidBodyComponent>();
 	}
 
-	void Update(double deltaTime) {
+	void Update(double deltaTime, JobSystem& jobSystem) {
+		Pool<TransformComponent>* transforms = registry->GetMutablePool<TransformComponent>();
+		Pool<RigidBodyComponent>* rigidBodies = registry->GetMutablePool<RigidBodyComponent>();
+		if (registry->GetStorageMode() == StorageMode::Archetypes || !transforms || !rigidBodies) {
+			UpdateEntities(deltaTime, jobSystem);
+			return;
+		}
+
+		// the entities with both components sit at the same packed indices [0, count) of both pools
+		const int count = AlignPools(*transforms, *rigidBodies);
 
-		for (Entity entity : GetSystemEntities()) {
-			TransformComponent& transform = entity.GetComponent<TransformComponent>();
-			const RigidBodyComponent rigidbody = entity.GetComponent<RigidBodyComponent>();
+		TransformColumns& transformColumns = transforms->GetColumns();
+		RigidBodyColumns& rigidBodyColumns = rigidBodies->GetColumns();
+		const IntegrationArrays arrays = {
+			transformColumns.positionX.Data(),
+			transformColumns.positionY.Data(),
+			rigidBodyColumns.velocityX.Data(),
+			rigidBodyColumns.velocityY.Data(),
+			rigidBodyColumns.accelerationX.Data(),
+			rigidBodyColumns.accelerationY.Data(),
+			rigidBodyColumns.damping.Data(),
+			transforms->GetChangedTicks(),
+			rigidBodies->GetChangedTicks()
+		};
+		const std::uint32_t tick = registry->GetTick();
+		const float step = static_cast<float>(deltaTime);
+
+		jobSystem.ParallelFor(count, [&arrays, step, tick](int begin, int end) {
+			Integration::Integrate(arrays, begin, end, step, tick);
+		});
+	}
 
-			transform.position.x += rigidbody.velocity.x * deltaTime;
-			transform.position.y += rigidbody.velocity.y * deltaTime;
+private:
+	/*
+	 Sort the pools against each other when entities joined, left or moved in either of them
+	 @return number of entities that have both components
+	*/
+	int AlignPools(Pool<TransformComponent>& transforms, Pool<RigidBodyComponent>& rigidBodies) {
+		if (transforms.GetLayoutVersion() != transformsVersion || rigidBodies.GetLayoutVersion() != rigidBodiesVersion) {
+			rigidBodies.SortAs(transforms);
+			sharedCount = transforms.SortAs(rigidBodies);
+			transformsVersion = transforms.GetLayoutVersion();
+			rigidBodiesVersion = rigidBodies.GetLayoutVersion();
 		}
+		return sharedCount;
 	}
-};
\ No newline at end of file
+
+	// archetype storage, one entity at a time through the component proxies with the same math as the kernels
+	void UpdateEntities(double deltaTime, JobSystem& jobSystem) {
+		const SystemEntities entities = GetSystemEntities();
+		const float step = static_cast<float>(deltaTime);
+		jobSystem.ParallelFor(static_cast<int>(entities.size()), [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				Entity entity = entities[i];
+				auto rigidbody = GetMutableComponent<RigidBodyComponent>(entity);
+				const float divisor = 1.0f + rigidbody.damping * step;
+				rigidbody.velocity.x = (rigidbody.velocity.x + rigidbody.acceleration.x * step) / divisor;
+				rigidbody.velocity.y = (rigidbody.velocity.y + rigidbody.acceleration.y * step) / divisor;
+				if (rigidbody.velocity.x == 0 && rigidbody.velocity.y == 0) {
+					continue;
+				}
+				auto transform = GetMutableComponent<TransformComponent>(entity);
+
+				transform.position.x = transform.position.x + rigidbody.velocity.x * step;
+				transform.position.y = transform.position.y + rigidbody.velocity.y * step;
+			}
+		});
+	}
+
+	std::uint32_t transformsVersion = 0;
+	std::uint32_t rigidBodiesVersion = 0;
+	int sharedCount = 0;
+};
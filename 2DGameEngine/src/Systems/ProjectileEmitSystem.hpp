@@ -2,6 +2,8 @@
 
 #include <SDL.h>
 #include "../ECS/ECS.hpp"
+#include "../ECS/CommandBuffer.hpp"
+#include "../ECS/Prefab.hpp"
 #include "../Components/ProjectileEmitterComponent.hpp"
 #include "../Components/TransformComponent.hpp"
 #include "../Components/RigidBodyComponent.hpp"
@@ -15,7 +17,14 @@ class ProjectileEmitSystem : public System {
 public:
     ProjectileEmitSystem() {
         RequireComponent<ProjectileEmitterComponent>();
-        RequireComponent<TransformComponent>();
+        RequireComponent<TransformComponent>(ComponentAccess::Read);
+        AccessComponent<SpriteComponent>(ComponentAccess::Read);
+
+        // position, velocity and the projectile settings come from the emitter, everything else is shared
+        projectilePrefab.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
+        projectilePrefab.AddComponent<BoxColliderComponent>(4, 4);
+        projectilePrefab.Group("projectiles");
+        playerTag = Registry::GetTagId("player");
     }
 
     void SubscribeToEvents(std::unique_ptr<EventBus>& eventBus) {
@@ -25,18 +34,10 @@ public:
     void OnKeyPressed(KeyPressedEvent& event) {
         if (event.symbol == SDLK_SPACE) {
             for (auto entity : GetSystemEntities()) {
-                if (entity.HasTag("player")) {
-                    const auto projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
-                    const auto transform = entity.GetComponent<TransformComponent>();
+                if (entity.HasTag(playerTag)) {
+                    const auto projectileEmitter = GetComponent<ProjectileEmitterComponent>(entity);
                     const auto rigidbody = entity.GetComponent<RigidBodyComponent>();
-
-                    // If parent entity has sprite, start the projectile position in the middle of the entity
-                    glm::vec2 projectilePosition = transform.position;
-                    if (entity.HasComponent<SpriteComponent>()) {
-                        auto sprite = entity.GetComponent<SpriteComponent>();
-                        projectilePosition.x += (transform.scale.x * sprite.width / 2);
-                        projectilePosition.y += (transform.scale.y * sprite.height / 2);
-                    }
+                    const glm::vec2 projectilePosition = GetProjectilePosition(entity);
 
                     // If parent entity direction is controlled by the keyboard keys, modify the direction of the projectile accordingly
                     glm::vec2 projectileVelocity = projectileEmitter.projectileVelocity;
@@ -50,22 +51,20 @@ public:
                     projectileVelocity.y = projectileEmitter.projectileVelocity.y * directionY;
 
                     // Create new projectile entity and add it to the world
-                    Entity projectile = entity.registry->CreateEntity();
-                    projectile.Group("projectiles");
-                    projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0, 1.0), 0.0);
-                    projectile.AddComponent<RigidBodyComponent>(projectileVelocity);
-                    projectile.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
-                    projectile.AddComponent<BoxColliderComponent>(4, 4);
-                    projectile.AddComponent<ProjectileComponent>(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration);
+                    entity.registry->Instantiate(projectilePrefab,
+                        TransformComponent(projectilePosition, glm::vec2(1.0, 1.0), 0.0),
+                        RigidBodyComponent(projectileVelocity),
+                        ProjectileComponent(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration));
                 }
             }
         }
     }
 
     void Update(std::unique_ptr<Registry>& registry) {
+        // projectiles are created through the command buffer so the system can run on any thread
+        CommandBuffer& commands = registry->GetCommandBuffer();
         for (auto entity : GetSystemEntities()) {
-            auto& projectileEmitter = entity.GetComponent<ProjectileEmitterComponent>();
-            const auto transform = entity.GetComponent<TransformComponent>();
+            const auto& projectileEmitter = GetComponent<ProjectileEmitterComponent>(entity);
 
             // If emission frequency is zero, bypass re-emission logic
             if (projectileEmitter.repeatFrequency == 0) {
@@ -74,25 +73,31 @@ public:
 
             // Check if its time to re-emit a new projectile
             if (SDL_GetTicks() - projectileEmitter.lastEmissionTime > projectileEmitter.repeatFrequency) {
-                glm::vec2 projectilePosition = transform.position;
-                if (entity.HasComponent<SpriteComponent>()) {
-                    const auto sprite = entity.GetComponent<SpriteComponent>();
-                    projectilePosition.x += (transform.scale.x * sprite.width / 2);
-                    projectilePosition.y += (transform.scale.y * sprite.height / 2);
-                }
-
-                // Add a new projectile entity to the registry
-                Entity projectile = registry->CreateEntity();
-                projectile.Group("projectiles");
-                projectile.AddComponent<TransformComponent>(projectilePosition, glm::vec2(1.0, 1.0), 0.0);
-                projectile.AddComponent<RigidBodyComponent>(projectileEmitter.projectileVelocity);
-                projectile.AddComponent<SpriteComponent>("bullet-image", 4, 4, 4);
-                projectile.AddComponent<BoxColliderComponent>(4, 4);
-                projectile.AddComponent<ProjectileComponent>(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration);
+                // Add a new projectile entity to the registry in its next update
+                commands.Instantiate(projectilePrefab,
+                    TransformComponent(GetProjectilePosition(entity), glm::vec2(1.0, 1.0), 0.0),
+                    RigidBodyComponent(projectileEmitter.projectileVelocity),
+                    ProjectileComponent(projectileEmitter.isFriendly, projectileEmitter.hitPercentDamage, projectileEmitter.projectileDuration));
 
                 // Update the projectile emitter component last emission to the current milliseconds
-                projectileEmitter.lastEmissionTime = SDL_GetTicks();
+                GetMutableComponent<ProjectileEmitterComponent>(entity).lastEmissionTime = SDL_GetTicks();
             }
         }
     }
+
+private:
+    // If the emitting entity has a sprite, projectiles start in the middle of it
+    glm::vec2 GetProjectilePosition(Entity entity) const {
+        const auto transform = GetComponent<TransformComponent>(entity);
+        glm::vec2 projectilePosition = transform.position;
+        if (entity.HasComponent<SpriteComponent>()) {
+            const auto sprite = entity.GetComponent<SpriteComponent>();
+            projectilePosition.x += (transform.scale.x * sprite.width / 2);
+            projectilePosition.y += (transform.scale.y * sprite.height / 2);
+        }
+        return projectilePosition;
+    }
+
+    Prefab projectilePrefab;
+    int playerTag;
 };
\ No newline at end of file
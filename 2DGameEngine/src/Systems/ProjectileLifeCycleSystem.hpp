@@ -1,21 +1,37 @@
 #pragma once
 
 #include "../ECS/ECS.hpp"
+#include "../JobSystem/JobSystem.hpp"
 #include "../Components/ProjectileComponent.hpp"
+#include <vector>
 
 class ProjectileLifeCycleSystem : public System {
 public:
 	ProjectileLifeCycleSystem() {
-		RequireComponent<ProjectileComponent>();
+		RequireComponent<ProjectileComponent>(ComponentAccess::Read);
 	}
 
-	void Update() {
-		for (Entity entity : GetSystemEntities()) {
-			ProjectileComponent projectile = entity.GetComponent<ProjectileComponent>();
+	void Update(JobSystem& jobSystem) {
+		const SystemEntities entities = GetSystemEntities();
+		const Uint32 ticks = SDL_GetTicks();
 
-			if (SDL_GetTicks() - projectile.startTime > projectile.duration) {
-				entity.Kill();
+		// check lifetimes in parallel, then kill the expired projectiles in order
+		expired.resize(entities.size());
+		jobSystem.ParallelFor(static_cast<int>(entities.size()), [&](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				const ProjectileComponent& projectile = GetComponent<ProjectileComponent>(entities[i]);
+				expired[i] = ticks - projectile.startTime > projectile.duration;
+			}
+		});
+
+		for (int i = 0; i < entities.size(); i++) {
+			if (expired[i]) {
+				entities[i].Kill();
 			}
 		}
 	}
-};
\ No newline at end of file
+
+private:
+	// one flag per system entity, reused between frames
+	std::vector<char> expired;
+};
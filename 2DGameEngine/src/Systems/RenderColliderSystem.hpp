@@ -9,14 +9,14 @@ class RenderColliderSystem : public System {
 
 public:
 	RenderColliderSystem() {
-		RequireComponent<TransformComponent>();
-		RequireComponent<BoxColliderComponent>();
+		RequireComponent<TransformComponent>(ComponentAccess::Read);
+		RequireComponent<BoxColliderComponent>(ComponentAccess::Read);
 	}
 
 	void Update(SDL_Renderer* renderer, SDL_Rect& camera, bool collision) {
 		for (Entity entity : GetSystemEntities()) {
-			const TransformComponent transform = entity.GetComponent<TransformComponent>();
-			const BoxColliderComponent collider = entity.GetComponent<BoxColliderComponent>();
+			const TransformComponent& transform = GetComponent<TransformComponent>(entity);
+			const BoxColliderComponent& collider = GetComponent<BoxColliderComponent>(entity);
 
 			SDL_Rect colliderRect{
 				static_cast<int>(transform.position.x + collider.offset.x - camera.x),
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../ECS/ECS.hpp"
+#include "../ECS/SystemScheduler.hpp"
 #include <imgui/imgui.h>
 #include <imgui/imgui_sdl.h>
 #include <imgui/imgui_impl_sdl.h>
@@ -14,9 +15,12 @@
 
 class RenderGUISystem : public System {
 public:
-    RenderGUISystem() = default;
+    RenderGUISystem() {
+        // enemies are created from the GUI
+        RequireExclusiveAccess();
+    }
 
-    void Update(const std::unique_ptr<Registry>& registry, const SDL_Rect& camera) {
+    void Update(const std::unique_ptr<Registry>& registry, const SDL_Rect& camera, const SystemScheduler& systemScheduler) {
         ImGui::NewFrame();
 
         // Display a window to customize and create new enemies
@@ -101,6 +105,32 @@ public:
         }
         ImGui::End();
 
+        // Display every reflected field of an entity's components
+        if (ImGui::Begin("Entity inspector")) {
+            static int inspectedId = 0;
+            ImGui::InputInt("entity id", &inspectedId);
+            if (inspectedId >= 0 && inspectedId < registry->GetEntityIdCount()) {
+                DrawComponents(*registry, registry->GetEntity(inspectedId));
+            }
+        }
+        ImGui::End();
+
+        // Display the memory and occupancy of the registry
+        if (ImGui::Begin("Registry stats")) {
+            DrawStats(registry->GetStats());
+        }
+        ImGui::End();
+
+        // Display how long every stage of the system pipeline took last frame
+        if (ImGui::Begin("System stages")) {
+            const char* stageNames[] = { "pre update", "update", "post update", "render" };
+            for (int stage = 0; stage < SYSTEM_STAGE_COUNT; stage++) {
+                const SystemStage systemStage = static_cast<SystemStage>(stage);
+                ImGui::Text("%s: %.2f ms, %d systems", stageNames[stage], systemScheduler.GetStageMilliseconds(systemStage), systemScheduler.GetStageTaskCount(systemStage));
+            }
+        }
+        ImGui::End();
+
         // Display a small overlay window to display the map position using the mouse
         ImGuiWindowFlags windowFlags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoNav;
         ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always, ImVec2(0, 0));
@@ -117,4 +147,97 @@ public:
         ImGui::Render();
         ImGuiSDL::Render(ImGui::GetDrawData());
     }
+
+private:
+    // one section per component, fields are read through the component metadata so any reflected type shows up
+    void DrawComponents(const Registry& registry, Entity entity) {
+        for (int componentId = 0; componentId < IComponent::GetCount(); componentId++) {
+            if (!registry.HasComponent(entity, componentId)) {
+                continue;
+            }
+            const ComponentInfo& info = IComponent::GetInfo(componentId);
+            if (!ImGui::CollapsingHeader(info.name, ImGuiTreeNodeFlags_DefaultOpen)) {
+                continue;
+            }
+
+            // a copy, components of pools that store fields in separate arrays have no address
+            void* component = ::operator new(info.size, std::align_val_t(info.alignment));
+            registry.CopyComponent(entity, componentId, component);
+            for (const FieldInfo& field : info.fields) {
+                DrawField(field, static_cast<const std::byte*>(component) + field.offset);
+            }
+            info.destroy(component);
+            ::operator delete(component, std::align_val_t(info.alignment));
+        }
+    }
+
+    void DrawStats(const RegistryStats& stats) {
+        ImGui::Text("entities: %d alive, %d ids, %d free", stats.aliveEntityCount, stats.entityIdCount, stats.freeIdCount);
+        ImGui::Text("pending: %d adds, %d kills, %d commands", stats.pendingAddCount, stats.pendingKillCount, stats.pendingCommandCount);
+        ImGui::Text("signatures: %d", stats.signatureCount);
+        ImGui::Text("memory: %.1f KB", stats.GetTotalBytes() / 1024.0f);
+
+        if (ImGui::CollapsingHeader("Pools", ImGuiTreeNodeFlags_DefaultOpen)) {
+            ImGui::Columns(6, "pools");
+            ImGui::Text("component"); ImGui::NextColumn();
+            ImGui::Text("count"); ImGui::NextColumn();
+            ImGui::Text("capacity"); ImGui::NextColumn();
+            ImGui::Text("KB"); ImGui::NextColumn();
+            ImGui::Text("growths"); ImGui::NextColumn();
+            ImGui::Text("unused"); ImGui::NextColumn();
+            ImGui::Separator();
+            for (const PoolStats& pool : stats.pools) {
+                ImGui::Text("%s%s", pool.name, pool.shared ? " (shared)" : ""); ImGui::NextColumn();
+                ImGui::Text("%d", pool.count); ImGui::NextColumn();
+                ImGui::Text("%d", pool.capacity); ImGui::NextColumn();
+                ImGui::Text("%.1f", pool.bytes / 1024.0f); ImGui::NextColumn();
+                ImGui::Text("%d", pool.growthCount); ImGui::NextColumn();
+                ImGui::Text("%.0f%%", pool.fragmentation * 100.0f); ImGui::NextColumn();
+            }
+            ImGui::Columns(1);
+        }
+
+        if (ImGui::CollapsingHeader("Systems", ImGuiTreeNodeFlags_DefaultOpen)) {
+            for (const SystemStats& system : stats.systems) {
+                ImGui::Text("%s: %d entities, %.1f KB", system.name.c_str(), system.entityCount, system.bytes / 1024.0f);
+            }
+        }
+
+        if (stats.archetypeCount > 0 && ImGui::CollapsingHeader("Archetypes", ImGuiTreeNodeFlags_DefaultOpen)) {
+            ImGui::Text("%d archetypes, %d chunks, %.1f KB", stats.archetypeCount, stats.chunkCount, stats.chunkBytes / 1024.0f);
+            ImGui::Text("unused rows: %.0f%%", stats.chunkFragmentation * 100.0f);
+        }
+
+        ImGui::Text("entity arrays: %.1f KB", stats.entityBytes / 1024.0f);
+        ImGui::Text("tags and groups: %.1f KB", stats.tagAndGroupBytes / 1024.0f);
+        ImGui::Text("command buffers: %.1f KB", stats.commandBufferBytes / 1024.0f);
+    }
+
+    void DrawField(const FieldInfo& field, const std::byte* value) {
+        switch (field.type) {
+        case FieldType::Bool:
+            ImGui::Text("%s: %s", field.name, *reinterpret_cast<const bool*>(value) ? "true" : "false");
+            break;
+        case FieldType::Int:
+            ImGui::Text("%s: %d", field.name, *reinterpret_cast<const int*>(value));
+            break;
+        case FieldType::Float:
+            ImGui::Text("%s: %.2f", field.name, *reinterpret_cast<const float*>(value));
+            break;
+        case FieldType::Double:
+            ImGui::Text("%s: %.2f", field.name, *reinterpret_cast<const double*>(value));
+            break;
+        case FieldType::Vec2: {
+            const glm::vec2& vector = *reinterpret_cast<const glm::vec2*>(value);
+            ImGui::Text("%s: (%.1f, %.1f)", field.name, vector.x, vector.y);
+            break;
+        }
+        case FieldType::String:
+            ImGui::Text("%s: %s", field.name, reinterpret_cast<const std::string*>(value)->c_str());
+            break;
+        case FieldType::Bytes:
+            ImGui::Text("%s: %zu bytes", field.name, field.size);
+            break;
+        }
+    }
 };
\ No newline at end of file
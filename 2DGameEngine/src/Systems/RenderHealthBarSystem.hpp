@@ -1,25 +1,47 @@
 #pragma once
 
 #include "../ECS/ECS.hpp"
+#include "../ECS/View.hpp"
 #include "../Components/TransformComponent.hpp"
 #include "../Components/SpriteComponent.hpp"
 #include "../Components/HealthComponent.hpp"
 #include "../AssetStore/AssetStore.hpp"
 #include <SDL.h>
+#include <vector>
 
 class RenderHealthBarSystem : public System {
 public:
     RenderHealthBarSystem() {
-        RequireComponent<TransformComponent>();
-        RequireComponent<SpriteComponent>();
-        RequireComponent<HealthComponent>();
+        RequireComponent<TransformComponent>(ComponentAccess::Read);
+        RequireComponent<SpriteComponent>(ComponentAccess::Read);
+        RequireComponent<HealthComponent>(ComponentAccess::Read);
+    }
+
+    ~RenderHealthBarSystem() {
+        ClearLabels();
+    }
+
+    void ClearLabels() {
+        for (HealthLabel& label : labels) {
+            if (label.texture) {
+                SDL_DestroyTexture(label.texture);
+            }
+        }
+        labels.clear();
+    }
+
+    // free the cached labels of entities that lost their health component or were killed
+    void ReleaseLabels(std::span<const Entity> entities) {
+        for (Entity entity : entities) {
+            if (entity.GetId() < labels.size() && labels[entity.GetId()].texture) {
+                SDL_DestroyTexture(labels[entity.GetId()].texture);
+                labels[entity.GetId()] = HealthLabel();
+            }
+        }
     }
 
     void Update(SDL_Renderer* renderer, const std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
-        for (auto entity : GetSystemEntities()) {
-            const auto transform = entity.GetComponent<TransformComponent>();
-            const auto sprite = entity.GetComponent<SpriteComponent>();
-            const auto health = entity.GetComponent<HealthComponent>();
+        registry->View<const TransformComponent, const SpriteComponent, const HealthComponent>().Each([&](Entity entity, const TransformComponent& transform, const SpriteComponent& sprite, const HealthComponent& health) {
 
             // Draw a the health bar with the correct color for the percentage
             SDL_Color healthBarColor = { 255, 255, 255 };
@@ -52,25 +74,41 @@ public:
             SDL_SetRenderDrawColor(renderer, healthBarColor.r, healthBarColor.g, healthBarColor.b, 255);
             SDL_RenderFillRect(renderer, &healthBarRectangle);
 
-            // Render the health percentage text label indicator
-            std::string healthText = std::to_string(health.healthPercentage);
-            SDL_Surface* surface = TTF_RenderText_Blended(assetStore->GetFont("charriot-font-10"), healthText.c_str(), healthBarColor);
-            SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-            SDL_FreeSurface(surface);
+            // Render the health percentage text label indicator, the texture is only rebuilt when the health changed
+            if (entity.GetId() >= labels.size()) {
+                labels.resize(entity.GetId() + 1);
+            }
+            HealthLabel& label = labels[entity.GetId()];
+            if (!label.texture || HasChanged<HealthComponent>(entity)) {
+                if (label.texture) {
+                    SDL_DestroyTexture(label.texture);
+                }
+                std::string healthText = std::to_string(health.healthPercentage);
+                SDL_Surface* surface = TTF_RenderText_Blended(assetStore->GetFont("charriot-font-10"), healthText.c_str(), healthBarColor);
+                label.texture = SDL_CreateTextureFromSurface(renderer, surface);
+                SDL_FreeSurface(surface);
+                SDL_QueryTexture(label.texture, NULL, NULL, &label.width, &label.height);
+            }
 
-            int labelWidth = 0;
-            int labelHeight = 0;
-            SDL_QueryTexture(texture, NULL, NULL, &labelWidth, &labelHeight);
             SDL_Rect healthBarTextRectangle = {
                 static_cast<int>(healthBarPosX),
                 static_cast<int>(healthBarPosY) + 5,
-                labelWidth,
-                labelHeight
+                label.width,
+                label.height
             };
 
-            SDL_RenderCopy(renderer, texture, NULL, &healthBarTextRectangle);
-
-            SDL_DestroyTexture(texture);
-        }
+            SDL_RenderCopy(renderer, label.texture, NULL, &healthBarTextRectangle);
+        });
+        MarkRun();
     }
+
+private:
+    struct HealthLabel {
+        SDL_Texture* texture = nullptr;
+        int width = 0;
+        int height = 0;
+    };
+
+    // health text texture per entity id, an entity reusing an id has a newly added health component
+    std::vector<HealthLabel> labels;
 };
\ No newline at end of file
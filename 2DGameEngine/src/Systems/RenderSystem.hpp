@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../ECS/ECS.hpp"
+#include "../ECS/View.hpp"
 #include "../Components/TransformComponent.hpp"
 #include "../Components/SpriteComponent.hpp"
 #include "../AssetStore/AssetStore.hpp"
@@ -10,33 +11,26 @@
 class RenderSystem : public System {
 public:
 	RenderSystem() {
-		RequireComponent<TransformComponent>();
-		RequireComponent<SpriteComponent>();
+		RequireComponent<TransformComponent>(ComponentAccess::Read);
+		RequireComponent<SpriteComponent>(ComponentAccess::Read);
 	}
 
 	void Update(SDL_Renderer* renderer, SDL_Rect camera, std::unique_ptr<AssetStore>& assetStore) {
 
-		struct RenderableEntity{
-			TransformComponent transformComponent;
-			SpriteComponent spriteComponent;
-		};
+		// reuse the buffer between frames so sorting doesn't allocate
+		renderableEntities.clear();
 
-		std::vector<RenderableEntity> renderableEntities;
-
-		for (Entity entity : GetSystemEntities()) {
-			RenderableEntity renderableEntity;
-			renderableEntity.spriteComponent = entity.GetComponent<SpriteComponent>();
-			renderableEntity.transformComponent = entity.GetComponent<TransformComponent>();
-			renderableEntities.emplace_back(renderableEntity);
-		}
+		registry->View<const TransformComponent, const SpriteComponent>().Each([this](Entity, const TransformComponent& transform, const SpriteComponent& sprite) {
+			renderableEntities.push_back({ transform, &sprite });
+		});
 
 		std::sort(renderableEntities.begin(), renderableEntities.end(), [](const RenderableEntity& a, const RenderableEntity& b) {
-			return a.spriteComponent.zIndex < b.spriteComponent.zIndex;
+			return a.spriteComponent->zIndex < b.spriteComponent->zIndex;
 		});
 
-		for (RenderableEntity entity : renderableEntities) {
-			const TransformComponent transform = entity.transformComponent;
-			const SpriteComponent sprite = entity.spriteComponent;
+		for (const RenderableEntity& entity : renderableEntities) {
+			const TransformComponent& transform = entity.transformComponent;
+			const SpriteComponent& sprite = *entity.spriteComponent;
 
 			SDL_Rect src = sprite.src;
 
@@ -58,4 +52,13 @@ public:
 			);
 		}
 	}
+
+private:
+	struct RenderableEntity {
+		// a copy, read access to transforms hands out values rather than references
+		TransformComponent transformComponent;
+		const SpriteComponent* spriteComponent;
+	};
+
+	std::vector<RenderableEntity> renderableEntities;
 };
\ No newline at end of file
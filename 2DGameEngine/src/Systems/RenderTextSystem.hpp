@@ -9,12 +9,12 @@ class RenderTextSystem : public System {
 public:
 
 	RenderTextSystem() {
-		RequireComponent<TextLabelComponent>();
+		RequireComponent<TextLabelComponent>(ComponentAccess::Read);
 	}
 
 	void Update(SDL_Renderer* renderer, std::unique_ptr<AssetStore>& assetStore, const SDL_Rect& camera) {
 		for (Entity entity : GetSystemEntities()) {
-			const TextLabelComponent textLabel = entity.GetComponent<TextLabelComponent>();
+			const TextLabelComponent& textLabel = GetComponent<TextLabelComponent>(entity);
 
 			SDL_Surface* surface = TTF_RenderText_Blended(assetStore->GetFont(textLabel.assetId), textLabel.text.c_str(), textLabel.color);
 			SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
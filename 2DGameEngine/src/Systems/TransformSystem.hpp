@@ -0,0 +1,268 @@
+#pragma once
+
+#include "../ECS/ECS.hpp"
+#include "../JobSystem/JobSystem.hpp"
+#include "../Components/TransformComponent.hpp"
+#include "../Components/ParentComponent.hpp"
+#include "../Logger/Logger.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ TransformSystem
+ Computes the world transform of every entity with a ParentComponent from its
+ local transform and the world transform of its parent. Every hierarchy is stored
+ as one tree: a contiguous range of nodes that starts with the root (an entity
+ without a parent) followed by its descendants sorted by depth, so a
+ parent always comes before its children. World matrices are cached per node.
+ A frame only walks the trees whose root moved or where a local transform changed,
+ and inside those trees only recomputes the changed nodes and their descendants.
+ Trees don't share nodes, so they are processed in parallel
+*/
+class TransformSystem : public System {
+public:
+	TransformSystem() {
+		RequireComponent<TransformComponent>();
+		RequireComponent<ParentComponent>(ComponentAccess::Read);
+	}
+
+	void Update(JobSystem& jobSystem) {
+		const Pool<ParentComponent>* parents = registry->GetStorageMode() == StorageMode::Pools ? registry->GetPool<ParentComponent>() : nullptr;
+
+		/*
+		 A child that was given another parent is only noticed while marking, the rebuild
+		 marks everything. Archetype storage doesn't track changes, so every frame rebuilds
+		*/
+		if (!parents || NeedsRebuild(*parents) || !MarkDirtyNodes(*parents)) {
+			Rebuild(parents);
+		}
+
+		dirtyTrees.clear();
+		for (int tree = 0; tree < trees.size(); tree++) {
+			if (dirtyTreeFlags[tree]) {
+				dirtyTrees.push_back(tree);
+				dirtyTreeFlags[tree] = 0;
+			}
+		}
+
+		jobSystem.ParallelFor(static_cast<int>(dirtyTrees.size()), [this](int begin, int end) {
+			for (int i = begin; i < end; i++) {
+				PropagateTree(trees[dirtyTrees[i]]);
+			}
+		}, 4);
+
+		MarkRun();
+	}
+
+private:
+	struct Node {
+		EntityHandle entity;
+		// index of the parent node, -1 for the root of a tree
+		int parentNode;
+		// parent the tree was built with, a different one means the trees have to be rebuilt
+		EntityHandle parent;
+		int tree;
+	};
+
+	// what an entity is while the trees are built
+	enum NodeKind : std::uint8_t {
+		NotInSystem,
+		// its parent is alive and has a transform
+		Attached,
+		// no parent, or the parent is gone or has no transform. It keeps its transform and can be a root
+		Detached
+	};
+
+	// nodePerPackedIndex entry of detached entities, a change to their parent component rebuilds the trees
+	static constexpr int DETACHED_NODE = -2;
+
+	struct Tree {
+		// nodes [begin, end), nodes[begin] is the root
+		int begin;
+		int end;
+	};
+
+	static glm::mat3 ToMatrix(glm::vec2 position, glm::vec2 scale, double rotation) {
+		const float radians = glm::radians(static_cast<float>(rotation));
+		const float cosine = std::cos(radians);
+		const float sine = std::sin(radians);
+		// columns: rotated and scaled x axis, rotated and scaled y axis, translation
+		return glm::mat3(
+			cosine * scale.x, sine * scale.x, 0.0f,
+			-sine * scale.y, cosine * scale.y, 0.0f,
+			position.x, position.y, 1.0f
+		);
+	}
+
+	static TransformComponent ToTransform(const glm::mat3& matrix) {
+		return TransformComponent(
+			glm::vec2(matrix[2][0], matrix[2][1]),
+			glm::vec2(glm::length(glm::vec2(matrix[0])), glm::length(glm::vec2(matrix[1]))),
+			glm::degrees(std::atan2(matrix[0][1], matrix[0][0]))
+		);
+	}
+
+	// the trees are rebuilt when children join or leave, or a root is gone
+	bool NeedsRebuild(const Pool<ParentComponent>& parents) const {
+		if (GetEntityLayoutVersion() != entitiesVersion || parents.GetLayoutVersion() != parentsVersion) {
+			return true;
+		}
+		for (const Tree& tree : trees) {
+			const Entity root(nodes[tree.begin].entity);
+			if (!registry->IsEntityAlive(root) || !registry->HasComponent<TransformComponent>(root)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Rebuild(const Pool<ParentComponent>* parents) {
+		nodes.clear();
+		trees.clear();
+
+		// children of every entity id as linked lists, and the roots in the order they are found
+		const int entityIdCount = registry->GetEntityIdCount();
+		firstChild.assign(entityIdCount, -1);
+		nextSibling.assign(entityIdCount, -1);
+		nodeKinds.assign(entityIdCount, NotInSystem);
+		roots.clear();
+
+		const SystemEntities entities = GetSystemEntities();
+		for (Entity entity : entities) {
+			const EntityHandle parentHandle = GetComponent<ParentComponent>(entity).parent;
+			const Entity parent(parentHandle);
+			const bool attached = parentHandle != ParentComponent::NO_PARENT && registry->IsEntityAlive(parent) && registry->HasComponent<TransformComponent>(parent);
+			nodeKinds[entity.GetId()] = attached ? Attached : Detached;
+		}
+		int attachedCount = 0;
+		for (Entity entity : entities) {
+			if (nodeKinds[entity.GetId()] != Attached) {
+				continue;
+			}
+			const int parentId = Entity(GetComponent<ParentComponent>(entity).parent).GetId();
+			if (nodeKinds[parentId] != Attached && firstChild[parentId] == -1) {
+				roots.push_back(registry->GetEntity(parentId).GetHandle());
+			}
+			nextSibling[entity.GetId()] = firstChild[parentId];
+			firstChild[parentId] = entity.GetId();
+			attachedCount++;
+		}
+
+		// breadth first from every root, which sorts the nodes of a tree by depth
+		for (EntityHandle root : roots) {
+			Tree tree;
+			tree.begin = static_cast<int>(nodes.size());
+			const int treeIndex = static_cast<int>(trees.size());
+			nodes.push_back({ root, -1, ParentComponent::NO_PARENT, treeIndex });
+			for (int node = tree.begin; node < nodes.size(); node++) {
+				const EntityHandle parent = nodes[node].entity;
+				for (int child = firstChild[Entity(parent).GetId()]; child != -1; child = nextSibling[child]) {
+					nodes.push_back({ registry->GetEntity(child).GetHandle(), node, parent, treeIndex });
+				}
+			}
+			tree.end = static_cast<int>(nodes.size());
+			trees.push_back(tree);
+		}
+
+		// attached entities that can't reach a root through their parents are parented in a cycle
+		const int unreachable = attachedCount - (static_cast<int>(nodes.size()) - static_cast<int>(trees.size()));
+		if (unreachable > 0) {
+			Logger::Err("TransformSystem: " + std::to_string(unreachable) + " entities are parented in a cycle and are not updated");
+		}
+
+		worldMatrices.assign(nodes.size(), glm::mat3(1.0f));
+		dirtyNodes.assign(nodes.size(), 1);
+		dirtyTreeFlags.assign(trees.size(), 1);
+
+		// packed index in the parent pool -> node, so the changed ticks can be scanned in order
+		if (parents) {
+			nodePerPackedIndex.assign(parents->GetSize(), -1);
+			for (Entity entity : entities) {
+				if (nodeKinds[entity.GetId()] == Detached) {
+					nodePerPackedIndex[parents->IndexOf(entity.GetId())] = DETACHED_NODE;
+				}
+			}
+			for (int node = 0; node < nodes.size(); node++) {
+				const int entityId = Entity(nodes[node].entity).GetId();
+				if (nodeKinds[entityId] == Attached) {
+					nodePerPackedIndex[parents->IndexOf(entityId)] = node;
+				}
+			}
+			parentsVersion = parents->GetLayoutVersion();
+		}
+		entitiesVersion = GetEntityLayoutVersion();
+	}
+
+	/*
+	 Flag the roots that moved and the children whose local transform changed since the last run
+	 @return false if a child was given another parent, or a detached entity's parent component changed
+	*/
+	bool MarkDirtyNodes(const Pool<ParentComponent>& parents) {
+		for (int tree = 0; tree < trees.size(); tree++) {
+			const int root = trees[tree].begin;
+			if (HasChanged<TransformComponent>(Entity(nodes[root].entity))) {
+				dirtyNodes[root] = 1;
+				dirtyTreeFlags[tree] = 1;
+			}
+		}
+
+		// one pass over the packed ticks, nothing else is read while nothing moves
+		const std::uint32_t* changedTicks = parents.GetChangedTicks();
+		const std::vector<ParentComponent>& parentComponents = parents.GetData();
+		const std::uint32_t lastRunTick = GetLastRunTick();
+		for (int index = 0; index < nodePerPackedIndex.size(); index++) {
+			const int node = nodePerPackedIndex[index];
+			if (changedTicks[index] < lastRunTick || node == -1) {
+				continue;
+			}
+			if (node == DETACHED_NODE || parentComponents[index].parent != nodes[node].parent) {
+				return false;
+			}
+			dirtyNodes[node] = 1;
+			dirtyTreeFlags[nodes[node].tree] = 1;
+		}
+		return true;
+	}
+
+	// recompute the nodes of a tree that changed or whose parent was recomputed, parents come first
+	void PropagateTree(const Tree& tree) {
+		if (dirtyNodes[tree.begin]) {
+			const TransformComponent root = GetComponent<TransformComponent>(Entity(nodes[tree.begin].entity));
+			worldMatrices[tree.begin] = ToMatrix(root.position, root.scale, root.rotation);
+		}
+		for (int node = tree.begin + 1; node < tree.end; node++) {
+			if (!dirtyNodes[node] && !dirtyNodes[nodes[node].parentNode]) {
+				continue;
+			}
+			// a recomputed node stays flagged until the end of the tree so its children follow
+			dirtyNodes[node] = 1;
+			const Entity entity(nodes[node].entity);
+			const ParentComponent& local = GetComponent<ParentComponent>(entity);
+			worldMatrices[node] = worldMatrices[nodes[node].parentNode] * ToMatrix(local.localPosition, local.localScale, local.localRotation);
+			GetMutableComponent<TransformComponent>(entity) = ToTransform(worldMatrices[node]);
+		}
+		std::fill(dirtyNodes.begin() + tree.begin, dirtyNodes.begin() + tree.end, 0);
+	}
+
+	std::vector<Node> nodes;
+	std::vector<Tree> trees;
+	// world matrix of every node, valid for the nodes that aren't dirty
+	std::vector<glm::mat3> worldMatrices;
+	std::vector<std::uint8_t> dirtyNodes;
+	std::vector<std::uint8_t> dirtyTreeFlags;
+	std::vector<int> dirtyTrees;
+	// node of every packed index of the parent pool, -1 for entities that aren't in a tree
+	std::vector<int> nodePerPackedIndex;
+	std::uint32_t parentsVersion = 0;
+	std::uint32_t entitiesVersion = 0;
+
+	// scratch buffers of Rebuild(), kept between rebuilds
+	std::vector<int> firstChild;
+	std::vector<int> nextSibling;
+	std::vector<NodeKind> nodeKinds;
+	std::vector<EntityHandle> roots;
+};